@@ -0,0 +1,155 @@
+#pragma once
+/**
+	@file
+	@brief a small harness of microbenchmarks
+	@author MITSUNARI Shigeo(@herumi)
+	@license modified new BSD license
+	http://opensource.org/licenses/BSD-3-Clause
+*/
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+	#ifdef _MSC_VER
+		#include <intrin.h>
+	#else
+		#include <x86intrin.h>
+	#endif
+	#define BLS_BENCH_HAS_RDTSC
+#endif
+
+namespace bench {
+
+/*
+	return the time stamp counter
+	0 if it is not available
+*/
+inline uint64_t getCycle()
+{
+#ifdef BLS_BENCH_HAS_RDTSC
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+inline double getNs()
+{
+	typedef std::chrono::steady_clock Clock;
+	return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+struct Result {
+	std::string name;
+	size_t sampleNum;
+	size_t iterPerSample;
+	double nsMedian;
+	double nsP10;
+	double nsP90;
+	double nsP99;
+	double cycleMedian; // 0 if the time stamp counter is not available
+	double getOpsPerSec() const { return nsMedian > 0 ? 1e9 / nsMedian : 0; }
+};
+
+/*
+	run a benchmark as follows
+	1. warm up by calling f for warmupNs
+	2. choose iterPerSample so that a sample takes sampleNs at least
+	3. take sampleNum samples and sort the time of an op of each sample
+	json prints a result as a JSON object per line (JSON Lines)
+*/
+class Runner {
+	bool json_;
+	size_t sampleNum_;
+	double warmupNs_;
+	double sampleNs_;
+	std::string filter_;
+	std::string prefix_;
+	static double getPercentile(const std::vector<double>& v, double p)
+	{
+		const size_t idx = std::min(v.size() - 1, size_t(p * (v.size() - 1) + 0.5));
+		return v[idx];
+	}
+	static std::string escape(const std::string& s)
+	{
+		std::string ret;
+		for (size_t i = 0; i < s.size(); i++) {
+			const char c = s[i];
+			if (c == '"' || c == '\\') ret += '\\';
+			ret += c;
+		}
+		return ret;
+	}
+public:
+	/*
+		prefix is put on the name of each benchmark such as "cpp" or "c"
+		run only the benchmarks whose names contain filter
+	*/
+	Runner(const std::string& prefix, bool json, size_t sampleNum = 31, const std::string& filter = "")
+		: json_(json)
+		, sampleNum_(sampleNum == 0 ? 1 : sampleNum)
+		, warmupNs_(50e6)
+		, sampleNs_(5e6)
+		, filter_(filter)
+		, prefix_(prefix)
+	{
+		if (!json_) {
+			printf("%-40s %12s %12s %12s %12s %12s %12s\n", "name", "ns/op", "ops/s", "cycles/op", "p10(ns)", "p90(ns)", "p99(ns)");
+		}
+	}
+	/*
+		sampleNum = 0 means the default given to the constructor
+		give a small sampleNum to a benchmark which takes seconds
+	*/
+	template<class F>
+	void run(const std::string& name, const F& f, size_t sampleNum = 0)
+	{
+		const std::string fullName = prefix_ + ":" + name;
+		if (!filter_.empty() && fullName.find(filter_) == std::string::npos) return;
+		if (sampleNum == 0) sampleNum = sampleNum_;
+		size_t warmupIter = 0;
+		const double begin = getNs();
+		double elapsed = 0;
+		do {
+			f();
+			warmupIter++;
+			elapsed = getNs() - begin;
+		} while (elapsed < warmupNs_);
+		const double nsPerOp = elapsed / warmupIter;
+		const size_t iterPerSample = std::max<size_t>(1, size_t(sampleNs_ / nsPerOp));
+		std::vector<double> nsVec(sampleNum), cycleVec(sampleNum);
+		for (size_t i = 0; i < sampleNum; i++) {
+			const double t = getNs();
+			const uint64_t c = getCycle();
+			for (size_t j = 0; j < iterPerSample; j++) {
+				f();
+			}
+			cycleVec[i] = double(getCycle() - c) / iterPerSample;
+			nsVec[i] = (getNs() - t) / iterPerSample;
+		}
+		std::sort(nsVec.begin(), nsVec.end());
+		std::sort(cycleVec.begin(), cycleVec.end());
+		Result r;
+		r.name = fullName;
+		r.sampleNum = sampleNum;
+		r.iterPerSample = iterPerSample;
+		r.nsMedian = getPercentile(nsVec, 0.5);
+		r.nsP10 = getPercentile(nsVec, 0.1);
+		r.nsP90 = getPercentile(nsVec, 0.9);
+		r.nsP99 = getPercentile(nsVec, 0.99);
+		r.cycleMedian = getPercentile(cycleVec, 0.5);
+		if (json_) {
+			printf("{\"name\":\"%s\",\"samples\":%zu,\"iterations\":%zu,\"ns_per_op\":%.1f,\"ops_per_sec\":%.1f,\"cycles_per_op\":%.1f,\"p10_ns\":%.1f,\"p90_ns\":%.1f,\"p99_ns\":%.1f}\n"
+				, escape(r.name).c_str(), r.sampleNum, r.iterPerSample, r.nsMedian, r.getOpsPerSec(), r.cycleMedian, r.nsP10, r.nsP90, r.nsP99);
+		} else {
+			printf("%-40s %12.1f %12.1f %12.1f %12.1f %12.1f %12.1f\n"
+				, r.name.c_str(), r.nsMedian, r.getOpsPerSec(), r.cycleMedian, r.nsP10, r.nsP90, r.nsP99);
+		}
+		fflush(stdout);
+	}
+};
+
+} // bench
@@ -0,0 +1,467 @@
+/*
+	benchmark of the C++ API
+*/
+#include <bls.hpp>
+#include <cybozu/option.hpp>
+#include <cybozu/exception.hpp>
+#include <thread>
+#include <sstream>
+#include "bench.hpp"
+#include "../src/bls_rand.hpp"
+
+const size_t kTbl[] = { 2, 16, 128 };
+const size_t aggregateN = 1000;
+const size_t largeN = 1000000;
+
+void benchKey(bench::Runner& r)
+{
+	bls::SecretKey sec;
+	sec.init();
+	bls::PublicKey pub;
+	r.run("SecretKey::init", [&] { sec.init(); });
+	r.run("SecretKey::getPublicKey", [&] { sec.getPublicKey(pub); });
+}
+
+void benchRand(bench::Runner& r)
+{
+	uint8_t seed[bls::rand::ChaCha20::seedSize] = {};
+	bls::rand::ChaCha20 rg;
+	rg.reseed(seed);
+	uint8_t buf[32];
+	r.run("ChaCha20::read(32 bytes)", [&] {
+		if (rg.needSeed()) rg.reseed(seed);
+		rg.read(buf, sizeof(buf));
+	});
+}
+
+/*
+	make keys in threadNum threads at once
+	ns/op is the time of keyNum keys for each thread
+*/
+void benchKeyGenThread(bench::Runner& r)
+{
+	const size_t keyNum = 100;
+	size_t maxThreadNum = std::thread::hardware_concurrency();
+	if (maxThreadNum == 0) maxThreadNum = 1;
+	for (size_t threadNum = 1; threadNum <= maxThreadNum; threadNum *= 2) {
+		const std::string name = "SecretKey::init(" + std::to_string(keyNum) + " keys,thread=" + std::to_string(threadNum) + ")";
+		r.run(name, [&] {
+			std::vector<std::thread> thVec;
+			for (size_t t = 0; t < threadNum; t++) {
+				thVec.push_back(std::thread([keyNum] {
+					bls::SecretKey sec;
+					for (size_t i = 0; i < keyNum; i++) sec.init();
+				}));
+			}
+			for (size_t t = 0; t < threadNum; t++) {
+				thVec[t].join();
+			}
+		}, 5);
+	}
+}
+
+void benchPublicKeyTable(bench::Runner& r)
+{
+	bls::SecretKey sec;
+	sec.init();
+	bls::PublicKey pub;
+	for (size_t w = 1; w <= 10; w++) {
+		bls::setPublicKeyTableWindow(w);
+		const std::string suf = "(w=" + std::to_string(w) + "," + std::to_string(bls::getPublicKeyTableMemorySize() / 1024) + "KB)";
+		r.run("SecretKey::getPublicKey" + suf, [&] { sec.getPublicKey(pub); });
+	}
+	bls::setPublicKeyTableWindow(4);
+}
+
+void benchSign(bench::Runner& r)
+{
+	bls::SecretKey sec;
+	sec.init();
+	bls::PublicKey pub;
+	sec.getPublicKey(pub);
+	const std::string m = "hello bls benchmark";
+	bls::Sign s;
+	sec.sign(s, m);
+	const bls::PreparedPublicKey ppub(pub);
+	r.run("Sign::setHashOf", [&] { s.setHashOf(m); });
+	r.run("SecretKey::sign", [&] { sec.sign(s, m); });
+	r.run("Sign::verify", [&] { s.verify(pub, m); });
+	r.run("Sign::verify(prepared)", [&] { s.verify(ppub, m); });
+	bls::setHashCacheCapacity(1024);
+	r.run("Sign::verify(hash cache)", [&] { s.verify(pub, m); });
+	bls::setHashCacheCapacity(0);
+}
+
+void benchShare(bench::Runner& r)
+{
+	const std::string m = "hello bls benchmark";
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(kTbl); i++) {
+		const size_t k = kTbl[i];
+		bls::SecretKeyVec msk(k);
+		bls::PublicKeyVec mpk(k);
+		for (size_t j = 0; j < k; j++) {
+			msk[j].init();
+			msk[j].getPublicKey(mpk[j]);
+		}
+		bls::SecretKeyVec secVec(k);
+		bls::SignVec signVec(k);
+		bls::IdVec idVec(k);
+		for (size_t j = 0; j < k; j++) {
+			idVec[j] = bls::Id(unsigned(j + 1));
+			secVec[j].set(msk, idVec[j]);
+			secVec[j].sign(signVec[j], m);
+		}
+		const std::string suf = "(k=" + std::to_string(k) + ")";
+		bls::SecretKey sec;
+		bls::PublicKey pub;
+		bls::Sign s;
+		r.run("SecretKey::set" + suf, [&] { sec.set(msk, idVec[0]); });
+		r.run("PublicKey::set" + suf, [&] { pub.set(mpk, idVec[0]); });
+		r.run("SecretKey::recover" + suf, [&] { sec.recover(secVec, idVec); });
+		r.run("Sign::recover" + suf, [&] { s.recover(signVec, idVec); });
+		// k shares of a committee of 2k members
+		const bls::LagrangeContext ctx(2 * k);
+		r.run("SecretKey::recover(ctx)" + suf, [&] { sec.recover(secVec, idVec, ctx); });
+		r.run("Sign::recover(ctx)" + suf, [&] { s.recover(signVec, idVec, ctx); });
+	}
+}
+
+void benchDeriveShares(bench::Runner& r)
+{
+	const size_t n = 1000;
+	const size_t k = 20;
+	bls::SecretKey sec;
+	sec.init();
+	bls::SecretKeyVec msk;
+	sec.getMasterSecretKey(msk, k);
+	bls::PublicKeyVec mpk;
+	bls::getMasterPublicKey(mpk, msk);
+	bls::IdVec idVec(n);
+	for (size_t i = 0; i < n; i++) {
+		idVec[i] = int(i + 1);
+	}
+	bls::SecretKeyVec secVec(n);
+	bls::PublicKeyVec pubVec(n);
+	const std::string suf = "(n=" + std::to_string(n) + ",k=" + std::to_string(k) + ")";
+	r.run("SecretKey::set" + suf, [&] {
+		for (size_t i = 0; i < n; i++) secVec[i].set(msk, idVec[i]);
+	}, 5);
+	r.run("deriveSecretShares" + suf, [&] { bls::deriveSecretShares(msk, idVec.data(), n, secVec.data()); }, 5);
+	r.run("PublicKey::set" + suf, [&] {
+		for (size_t i = 0; i < n; i++) pubVec[i].set(mpk, idVec[i]);
+	}, 5);
+	r.run("derivePublicShares" + suf, [&] { bls::derivePublicShares(mpk, idVec.data(), n, pubVec.data()); }, 5);
+}
+
+void benchAggregate(bench::Runner& r)
+{
+	bls::SecretKey sec;
+	bls::PublicKeyVec pubVec(aggregateN);
+	bls::SignVec signVec(aggregateN);
+	for (size_t i = 0; i < aggregateN; i++) {
+		sec.init();
+		sec.getPublicKey(pubVec[i]);
+		sec.sign(signVec[i], "abc");
+	}
+	const std::string suf = "(n=" + std::to_string(aggregateN) + ")";
+	bls::PublicKey pub;
+	bls::Sign s;
+	r.run("PublicKey::aggregate" + suf, [&] { pub.aggregate(pubVec); });
+	r.run("Sign::aggregate" + suf, [&] { s.aggregate(signVec); });
+}
+
+/*
+	make n distinct public keys quickly by pubVec[i] = (i + 1) pub
+*/
+void makePublicKeyVec(bls::PublicKeyVec& pubVec, size_t n)
+{
+	bls::SecretKey sec;
+	sec.init();
+	bls::PublicKey pub;
+	sec.getPublicKey(pub);
+	pubVec.resize(n);
+	pubVec[0] = pub;
+	for (size_t i = 1; i < n; i++) {
+		pubVec[i] = pubVec[i - 1];
+		pubVec[i].add(pub);
+	}
+}
+
+void addPublicKeyVec(bls::PublicKey& agg, const bls::PublicKeyVec& pubVec)
+{
+	agg = pubVec[0];
+	for (size_t i = 1; i < pubVec.size(); i++) {
+		agg.add(pubVec[i]);
+	}
+}
+
+void benchFastAggregateVerify(bench::Runner& r)
+{
+	const std::string m = "committee";
+	const size_t nTbl[] = { 64, 1024, 16384 };
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(nTbl); i++) {
+		const size_t n = nTbl[i];
+		bls::PublicKeyVec pubVec(n);
+		bls::SecretKey sec, sum;
+		for (size_t j = 0; j < n; j++) {
+			sec.init();
+			sec.getPublicKey(pubVec[j]);
+			if (j == 0) {
+				sum = sec;
+			} else {
+				sum.add(sec);
+			}
+		}
+		bls::Sign agg;
+		sum.sign(agg, m);
+		bls::AggregatePublicKeyCache cache;
+		const std::string suf = "(n=" + std::to_string(n) + ")";
+		bls::PublicKey pub;
+		r.run("PublicKey::add" + suf, [&] { addPublicKeyVec(pub, pubVec); });
+		r.run("AggregatePublicKeyCache::aggregate" + suf, [&] { bls::AggregatePublicKeyCache::aggregate(pub, pubVec.data(), n); });
+		r.run("fastAggregateVerify" + suf, [&] { bls::fastAggregateVerify(agg, pubVec.data(), n, m); });
+		r.run("fastAggregateVerify(cached)" + suf, [&] { bls::fastAggregateVerify(agg, pubVec.data(), n, m, &cache); });
+	}
+}
+
+void benchAffine(bench::Runner& r)
+{
+	bls::PublicKeyVec pubVec;
+	makePublicKeyVec(pubVec, aggregateN);
+	bls::PublicKeyVec normPubVec = pubVec;
+	bls::normalizeVec(normPubVec.data(), aggregateN);
+	std::vector<bls::AffinePublicKey> apubVec(aggregateN);
+	const std::string suf = "(n=" + std::to_string(aggregateN) + ")";
+	bls::PublicKey agg;
+	r.run("toAffineVec" + suf, [&] { bls::toAffineVec(apubVec.data(), pubVec.data(), aggregateN); });
+	r.run("PublicKey::add" + suf, [&] { addPublicKeyVec(agg, pubVec); });
+	r.run("PublicKey::add(normalized)" + suf, [&] { addPublicKeyVec(agg, normPubVec); });
+	r.run("PublicKey::aggregate(affine)" + suf, [&] { agg.aggregate(apubVec.data(), aggregateN); });
+}
+
+void benchCommitteeAggregator(bench::Runner& r)
+{
+	const size_t n = 1024;
+	bls::PublicKeyVec pubVec;
+	makePublicKeyVec(pubVec, n);
+	const bls::CommitteeAggregator ca(pubVec);
+	std::vector<uint8_t> bitmap((n + 7) / 8);
+	const int tbl[] = { 10, 50, 90 };
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(tbl); i++) {
+		std::fill(bitmap.begin(), bitmap.end(), 0);
+		bls::PublicKeyVec subVec;
+		for (size_t j = 0; j < n; j++) {
+			if (int((j * 37) % 100) < tbl[i]) {
+				bitmap[j / 8] |= 1 << (j % 8);
+				subVec.push_back(pubVec[j]);
+			}
+		}
+		const std::string suf = "(n=" + std::to_string(n) + "," + std::to_string(tbl[i]) + "%)";
+		bls::PublicKey agg;
+		r.run("PublicKey::add" + suf, [&] { addPublicKeyVec(agg, subVec); });
+		r.run("CommitteeAggregator::aggregate" + suf, [&] { ca.aggregate(agg, bitmap.data(), bitmap.size()); });
+	}
+}
+
+/*
+	sum of n scalar multiplications
+*/
+template<class G>
+void mulVecNaive(G& out, const G *vec, const bls::SecretKey *coeffVec, size_t n)
+{
+	out = G();
+	for (size_t i = 0; i < n; i++) {
+		G t;
+		bls::mulVec(t, &vec[i], &coeffVec[i], 1);
+		out.add(t);
+	}
+}
+
+void benchMulVec(bench::Runner& r)
+{
+	const size_t nTbl[] = { 100, 1000 };
+	const size_t maxN = nTbl[CYBOZU_NUM_OF_ARRAY(nTbl) - 1];
+	bls::PublicKeyVec pubVec;
+	makePublicKeyVec(pubVec, maxN);
+	bls::SignVec signVec(maxN);
+	bls::SecretKeyVec coeffVec(maxN);
+	bls::SecretKey sec;
+	sec.init();
+	for (size_t i = 0; i < maxN; i++) {
+		sec.sign(signVec[i], std::to_string(i));
+		coeffVec[i].init();
+	}
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(nTbl); i++) {
+		const size_t n = nTbl[i];
+		const std::string suf = "(n=" + std::to_string(n) + ")";
+		bls::Sign s;
+		bls::PublicKey pub;
+		r.run("G1 n muls" + suf, [&] { mulVecNaive(s, signVec.data(), coeffVec.data(), n); });
+		r.run("G1 mulVec" + suf, [&] { bls::mulVec(s, signVec.data(), coeffVec.data(), n); });
+		r.run("G2 n muls" + suf, [&] { mulVecNaive(pub, pubVec.data(), coeffVec.data(), n); });
+		r.run("G2 mulVec" + suf, [&] { bls::mulVec(pub, pubVec.data(), coeffVec.data(), n); });
+	}
+}
+
+void benchThreadPool(bench::Runner& r)
+{
+	const size_t n = 1024;
+	const size_t k = 5;
+	bls::SecretKey sec;
+	sec.init();
+	bls::PublicKey pub;
+	sec.getPublicKey(pub);
+	std::vector<std::string> msgVec(n);
+	for (size_t i = 0; i < n; i++) {
+		msgVec[i] = "pool" + std::to_string(i);
+	}
+	bls::SecretKeyVec msk;
+	sec.getMasterSecretKey(msk, k);
+	bls::PublicKeyVec mpk;
+	bls::getMasterPublicKey(mpk, msk);
+	bls::IdVec idVec(n);
+	for (size_t i = 0; i < n; i++) {
+		idVec[i] = int(i + 1);
+	}
+	const bls::PublicKeyVec pubVec(n, pub);
+	bls::SignVec signVec(n);
+	bls::PublicKeyVec sharePubVec(n);
+	bls::signBatch(signVec.data(), sec, msgVec.data(), n);
+	size_t maxThreadNum = std::thread::hardware_concurrency();
+	if (maxThreadNum == 0) maxThreadNum = 1;
+	for (size_t threadNum = 1; threadNum <= maxThreadNum; threadNum *= 2) {
+		bls::ThreadPool pool(threadNum);
+		const std::string suf = "(n=" + std::to_string(n) + ",thread=" + std::to_string(threadNum) + ")";
+		r.run("signBatch" + suf, [&] { bls::signBatch(signVec.data(), sec, msgVec.data(), n, &pool); }, 5);
+		r.run("verifyBatch" + suf, [&] { bls::verifyBatch(signVec.data(), pubVec.data(), msgVec.data(), n, 0, &pool); }, 5);
+		r.run("derivePublicShares" + suf, [&] { bls::derivePublicShares(mpk, idVec.data(), n, sharePubVec.data(), &pool); }, 5);
+	}
+}
+
+void benchSerialize(bench::Runner& r)
+{
+	bls::SecretKey sec;
+	sec.init();
+	bls::PublicKey pub;
+	sec.getPublicKey(pub);
+	bls::Sign s;
+	sec.sign(s, "abc");
+	uint8_t buf[bls::publicKeyUncompressedSize];
+	r.run("SecretKey::serialize", [&] { sec.serialize(buf); });
+	r.run("SecretKey::deserialize", [&] { sec.deserialize(buf, bls::secretKeySerializedSize); });
+	r.run("PublicKey::serialize", [&] { pub.serialize(buf); });
+	r.run("PublicKey::deserialize", [&] { pub.deserialize(buf, bls::publicKeySerializedSize); });
+	std::string str;
+	r.run("PublicKey::operator<<", [&] { std::ostringstream oss; oss << pub; str = oss.str(); });
+	r.run("PublicKey::deserialize(trusted)", [&] { pub.deserialize(buf, bls::publicKeySerializedSize, bls::DeserializeTrusted); });
+	r.run("PublicKey::serialize(uncompressed)", [&] { pub.serialize(buf, bls::PointUncompressed); });
+	r.run("PublicKey::deserialize(uncompressed)", [&] { pub.deserialize(buf, bls::publicKeyUncompressedSize); });
+	r.run("PublicKey::deserialize(uncompressed,trusted)", [&] { pub.deserialize(buf, bls::publicKeyUncompressedSize, bls::DeserializeTrusted); });
+	r.run("Sign::serialize", [&] { s.serialize(buf); });
+	r.run("Sign::deserialize", [&] { s.deserialize(buf, bls::signSerializedSize); });
+	r.run("Sign::serialize(uncompressed)", [&] { s.serialize(buf, bls::PointUncompressed); });
+	r.run("Sign::deserialize(uncompressed)", [&] { s.deserialize(buf, bls::signUncompressedSize); });
+}
+
+/*
+	reload largeN public keys with and without the check of the order
+*/
+void benchReload(bench::Runner& r)
+{
+	std::vector<uint8_t> buf(largeN * bls::publicKeySerializedSize);
+	{
+		bls::PublicKeyVec pubVec;
+		makePublicKeyVec(pubVec, largeN);
+		bls::normalizeVec(pubVec.data(), largeN);
+		for (size_t i = 0; i < largeN; i++) {
+			pubVec[i].serialize(&buf[i * bls::publicKeySerializedSize]);
+		}
+	}
+	bls::PublicKeyVec pubVec(largeN);
+	const std::string suf = "(n=" + std::to_string(largeN) + ")";
+	const bls::DeserializeMode modeTbl[] = { bls::DeserializeChecked, bls::DeserializeTrusted };
+	const char *nameTbl[] = { "reload(checked)", "reload(trusted)" };
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(modeTbl); i++) {
+		const bls::DeserializeMode mode = modeTbl[i];
+		r.run(nameTbl[i] + suf, [&] {
+			for (size_t j = 0; j < largeN; j++) {
+				if (!pubVec[j].deserialize(&buf[j * bls::publicKeySerializedSize], bls::publicKeySerializedSize, mode)) throw cybozu::Exception("bad key") << j;
+			}
+		}, 3);
+	}
+}
+
+void addSignVec(bls::Sign& agg, const bls::SignVec& signVec)
+{
+	agg = signVec[0];
+	for (size_t i = 1; i < signVec.size(); i++) {
+		agg.add(signVec[i]);
+	}
+}
+
+/*
+	aggregate largeN signatures by the chain of Sign::add and by Sign::aggregate
+*/
+void benchAggregateLarge(bench::Runner& r)
+{
+	bls::SecretKey sec;
+	sec.init();
+	bls::SignVec signVec(largeN);
+	sec.sign(signVec[0], "abc");
+	for (size_t i = 1; i < largeN; i++) {
+		signVec[i] = signVec[i - 1];
+		signVec[i].add(signVec[0]);
+	}
+	// as if they were deserialized
+	bls::normalizeVec(signVec.data(), largeN);
+	size_t threadNum = std::thread::hardware_concurrency();
+	if (threadNum == 0) threadNum = 1;
+	bls::ThreadPool pool(threadNum);
+	const std::string suf = "(n=" + std::to_string(largeN) + ")";
+	bls::Sign agg;
+	r.run("Sign::add" + suf, [&] { addSignVec(agg, signVec); }, 3);
+	r.run("Sign::aggregate" + suf, [&] { agg.aggregate(signVec); }, 3);
+	r.run("Sign::aggregate(pool)" + suf, [&] { agg.aggregate(signVec, &pool); }, 3);
+}
+
+int main(int argc, char *argv[])
+	try
+{
+	bool json = false;
+	size_t sampleNum;
+	std::string filter;
+	bool large = false;
+	cybozu::Option opt;
+	opt.appendBoolOpt(&json, "json", ": output a result as a JSON object per line (JSON Lines)");
+	opt.appendOpt(&sampleNum, 31, "n", ": the number of samples of each benchmark");
+	opt.appendOpt(&filter, "", "f", ": run the benchmarks whose names contain the string");
+	opt.appendBoolOpt(&large, "large", ": also run the benchmarks of 1M keys (they take minutes)");
+	opt.appendHelp("h");
+	if (!opt.parse(argc, argv)) {
+		opt.usage();
+		return 1;
+	}
+	bls::init();
+	bench::Runner r("cpp", json, sampleNum, filter);
+	benchRand(r);
+	benchKey(r);
+	benchKeyGenThread(r);
+	benchPublicKeyTable(r);
+	benchSign(r);
+	benchShare(r);
+	benchDeriveShares(r);
+	benchAggregate(r);
+	benchFastAggregateVerify(r);
+	benchAffine(r);
+	benchCommitteeAggregator(r);
+	benchMulVec(r);
+	benchThreadPool(r);
+	benchSerialize(r);
+	if (large) {
+		benchReload(r);
+		benchAggregateLarge(r);
+	}
+} catch (std::exception& e) {
+	fprintf(stderr, "ERR %s\n", e.what());
+	return 1;
+}
@@ -0,0 +1,122 @@
+/*
+	benchmark of the C API
+*/
+#include <bls_if.h>
+#include <cybozu/option.hpp>
+#include <string.h>
+#include "bench.hpp"
+
+const size_t kTbl[] = { 2, 16, 128 };
+const size_t aggregateN = 1000;
+
+void benchSign(bench::Runner& r)
+{
+	blsSecretKey sec;
+	blsPublicKey pub;
+	blsSign sign;
+	const char *m = "hello bls benchmark";
+	const size_t mSize = strlen(m);
+	r.run("blsSecretKeyInit", [&] { blsSecretKeyInit(&sec); });
+	r.run("blsSecretKeyGetPublicKey", [&] { blsSecretKeyGetPublicKey(&sec, &pub); });
+	r.run("blsHashToSign", [&] { blsHashToSign(&sign, m, mSize); });
+	r.run("blsSecretKeySign", [&] { blsSecretKeySign(&sec, &sign, m, mSize); });
+	blsPreparedPublicKey *ppub = blsPreparedPublicKeyCreate(&pub);
+	r.run("blsSignVerify", [&] { blsSignVerify(&sign, &pub, m, mSize); });
+	r.run("blsSignVerifyPrepared", [&] { blsSignVerifyPrepared(&sign, ppub, m, mSize); });
+	blsPreparedPublicKeyDestroy(ppub);
+}
+
+void benchShare(bench::Runner& r)
+{
+	const char *m = "hello bls benchmark";
+	const size_t mSize = strlen(m);
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(kTbl); i++) {
+		const size_t k = kTbl[i];
+		std::vector<blsSecretKey> msk(k), secVec(k);
+		std::vector<blsPublicKey> mpk(k);
+		std::vector<blsSign> signVec(k);
+		std::vector<blsId> idVec(k);
+		for (size_t j = 0; j < k; j++) {
+			blsSecretKeyInit(&msk[j]);
+			blsSecretKeyGetPublicKey(&msk[j], &mpk[j]);
+		}
+		for (size_t j = 0; j < k; j++) {
+			const uint64_t id[4] = { j + 1, 0, 0, 0 };
+			blsIdSet(&idVec[j], id);
+			blsSecretKeySet(&secVec[j], msk.data(), k, &idVec[j]);
+			blsSecretKeySign(&secVec[j], &signVec[j], m, mSize);
+		}
+		const std::string suf = "(k=" + std::to_string(k) + ")";
+		blsSecretKey sec;
+		blsPublicKey pub;
+		blsSign sign;
+		r.run("blsSecretKeySet" + suf, [&] { blsSecretKeySet(&sec, msk.data(), k, &idVec[0]); });
+		r.run("blsPublicKeySet" + suf, [&] { blsPublicKeySet(&pub, mpk.data(), k, &idVec[0]); });
+		r.run("blsSecretKeyRecover" + suf, [&] { blsSecretKeyRecover(&sec, secVec.data(), idVec.data(), k); });
+		r.run("blsSignRecover" + suf, [&] { blsSignRecover(&sign, signVec.data(), idVec.data(), k); });
+	}
+}
+
+void benchAggregate(bench::Runner& r)
+{
+	blsSecretKey sec;
+	std::vector<blsPublicKey> pubVec(aggregateN);
+	std::vector<blsSign> signVec(aggregateN);
+	for (size_t i = 0; i < aggregateN; i++) {
+		blsSecretKeyInit(&sec);
+		blsSecretKeyGetPublicKey(&sec, &pubVec[i]);
+		blsSecretKeySign(&sec, &signVec[i], "abc", 3);
+	}
+	const std::string suf = "(n=" + std::to_string(aggregateN) + ")";
+	blsPublicKey pub;
+	blsSign sign;
+	r.run("blsPublicKeyAggregate" + suf, [&] { blsPublicKeyAggregate(&pub, pubVec.data(), aggregateN); });
+	r.run("blsSignAggregate" + suf, [&] { blsSignAggregate(&sign, signVec.data(), aggregateN); });
+}
+
+void benchSerialize(bench::Runner& r)
+{
+	blsSecretKey sec;
+	blsPublicKey pub;
+	blsSign sign;
+	blsSecretKeyInit(&sec);
+	blsSecretKeyGetPublicKey(&sec, &pub);
+	blsSecretKeySign(&sec, &sign, "abc", 3);
+	uint8_t buf[BLS_PUBLICKEY_UNCOMPRESSED_SIZE];
+	r.run("blsSecretKeySerialize", [&] { blsSecretKeySerialize(&sec, buf, sizeof(buf)); });
+	r.run("blsSecretKeyDeserialize", [&] { blsSecretKeyDeserialize(&sec, buf, BLS_SECRETKEY_SERIALIZED_SIZE); });
+	r.run("blsPublicKeySerialize", [&] { blsPublicKeySerialize(&pub, buf, sizeof(buf)); });
+	r.run("blsPublicKeyDeserialize", [&] { blsPublicKeyDeserialize(&pub, buf, BLS_PUBLICKEY_SERIALIZED_SIZE); });
+	r.run("blsPublicKeySerializeUncompressed", [&] { blsPublicKeySerializeUncompressed(&pub, buf, sizeof(buf)); });
+	r.run("blsPublicKeyDeserialize(uncompressed)", [&] { blsPublicKeyDeserialize(&pub, buf, BLS_PUBLICKEY_UNCOMPRESSED_SIZE); });
+	r.run("blsSignSerialize", [&] { blsSignSerialize(&sign, buf, sizeof(buf)); });
+	r.run("blsSignDeserialize", [&] { blsSignDeserialize(&sign, buf, BLS_SIGN_SERIALIZED_SIZE); });
+	r.run("blsSignSerializeUncompressed", [&] { blsSignSerializeUncompressed(&sign, buf, sizeof(buf)); });
+	r.run("blsSignDeserialize(uncompressed)", [&] { blsSignDeserialize(&sign, buf, BLS_SIGN_UNCOMPRESSED_SIZE); });
+}
+
+int main(int argc, char *argv[])
+	try
+{
+	bool json = false;
+	size_t sampleNum;
+	std::string filter;
+	cybozu::Option opt;
+	opt.appendBoolOpt(&json, "json", ": output a result as a JSON object per line (JSON Lines)");
+	opt.appendOpt(&sampleNum, 31, "n", ": the number of samples of each benchmark");
+	opt.appendOpt(&filter, "", "f", ": run the benchmarks whose names contain the string");
+	opt.appendHelp("h");
+	if (!opt.parse(argc, argv)) {
+		opt.usage();
+		return 1;
+	}
+	blsInit();
+	bench::Runner r("c", json, sampleNum, filter);
+	benchSign(r);
+	benchShare(r);
+	benchAggregate(r);
+	benchSerialize(r);
+} catch (std::exception& e) {
+	fprintf(stderr, "ERR %s\n", e.what());
+	return 1;
+}
@@ -0,0 +1,65 @@
+/*
+	benchmark of GLV for G1 and GLS for G2
+*/
+#include <cybozu/option.hpp>
+#include <cybozu/random_generator.hpp>
+#include "../src/bls_glv.hpp"
+#include "../src/bls_qtbl.hpp"
+#include "bench.hpp"
+
+using namespace mcl::bn256;
+
+cybozu::RandomGenerator rg;
+
+void benchGLV(bench::Runner& r)
+{
+	G1 P;
+	mcl::bn::MapTo<Fp> mapTo;
+	mapTo.calcG1(P, Fp(123));
+	bls::glv::GLV1 glv1;
+	r.run("GLV1::init", [&] { glv1.init(BN::param.r, BN::param.p, P); }, 5);
+	r.run("GLV1::set", [&] { glv1.set(*reinterpret_cast<const Fp*>(bls::qtbl::glv1Beta), bls::qtbl::glv1Int); });
+	Fr x;
+	x.setRand(rg);
+	G1 Q;
+	r.run("G1::mul", [&] { G1::mul(Q, P, x); });
+	r.run("GLV1::mul", [&] { glv1.mul(Q, P, x); });
+}
+
+void benchGLS(bench::Runner& r)
+{
+	const G2& P = *reinterpret_cast<const G2*>(bls::qtbl::Q);
+	bls::glv::GLS2 gls2;
+	r.run("GLS2::init", [&] { gls2.init(BN::param.r, BN::param.p, BN::param.z, BN::param.xi, P); }, 5);
+	r.run("GLS2::set", [&] { gls2.set(reinterpret_cast<const Fp2*>(bls::qtbl::gls2G), bls::qtbl::gls2Int); });
+	Fr x;
+	x.setRand(rg);
+	G2 Q;
+	r.run("G2::mul", [&] { G2::mul(Q, P, x); });
+	r.run("GLS2::mul", [&] { gls2.mul(Q, P, x); });
+}
+
+int main(int argc, char *argv[])
+	try
+{
+	bool json = false;
+	size_t sampleNum;
+	std::string filter;
+	cybozu::Option opt;
+	opt.appendBoolOpt(&json, "json", ": output a result as a JSON object per line (JSON Lines)");
+	opt.appendOpt(&sampleNum, 31, "n", ": the number of samples of each benchmark");
+	opt.appendOpt(&filter, "", "f", ": run the benchmarks whose names contain the string");
+	opt.appendHelp("h");
+	if (!opt.parse(argc, argv)) {
+		opt.usage();
+		return 1;
+	}
+	BN::init(mcl::bn::CurveFp254BNb);
+	Fr::init(BN::param.r);
+	bench::Runner r("glv", json, sampleNum, filter);
+	benchGLV(r);
+	benchGLS(r);
+} catch (std::exception& e) {
+	fprintf(stderr, "ERR %s\n", e.what());
+	return 1;
+}
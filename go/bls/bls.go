@@ -2,11 +2,12 @@ package bls
 
 /*
 #cgo CFLAGS:-I../../include
-#cgo LDFLAGS:-lbls -lbls_if -lmcl -lgmp -lgmpxx -L../lib -L../../lib -L../../../mcl/lib -L../../mcl/lib  -lstdc++ -lcrypto
+#cgo LDFLAGS:-lbls -lbls_if -lmcl -lgmp -lgmpxx -L../lib -L../../lib -L../../../mcl/lib -L../../mcl/lib  -lstdc++ -lcrypto -lpthread
 #include "bls_if.h"
 */
 import "C"
 import "fmt"
+import "runtime"
 import "unsafe"
 
 func Init() {
@@ -39,6 +40,25 @@ func (id *Id) SetStr(s string) error {
 	return nil
 }
 
+// Serialize returns the compressed binary of BLS_ID_SERIALIZED_SIZE bytes
+func (id *Id) Serialize() []byte {
+	buf := make([]byte, C.BLS_ID_SERIALIZED_SIZE)
+	n := C.blsIdSerialize(id.getPointer(), getUint8Pointer(buf), C.size_t(len(buf)))
+	if n == 0 {
+		panic("implementation err. size of buf is small")
+	}
+	return buf
+}
+
+// Deserialize sets the binary made by Serialize
+func (id *Id) Deserialize(buf []byte) error {
+	err := C.blsIdDeserialize(id.getPointer(), getUint8Pointer(buf), C.size_t(len(buf)))
+	if err > 0 {
+		return fmt.Errorf("bad binary:%x", buf)
+	}
+	return nil
+}
+
 func (id *Id) Set(v []uint64) error {
 	if len(v) != 4 {
 		return fmt.Errorf("bad size", len(v))
@@ -73,6 +93,25 @@ func (sec *SecretKey) SetStr(s string) error {
 	return nil
 }
 
+// Serialize returns the compressed binary of BLS_SECRETKEY_SERIALIZED_SIZE bytes
+func (sec *SecretKey) Serialize() []byte {
+	buf := make([]byte, C.BLS_SECRETKEY_SERIALIZED_SIZE)
+	n := C.blsSecretKeySerialize(sec.getPointer(), getUint8Pointer(buf), C.size_t(len(buf)))
+	if n == 0 {
+		panic("implementation err. size of buf is small")
+	}
+	return buf
+}
+
+// Deserialize sets the binary made by Serialize
+func (sec *SecretKey) Deserialize(buf []byte) error {
+	err := C.blsSecretKeyDeserialize(sec.getPointer(), getUint8Pointer(buf), C.size_t(len(buf)))
+	if err > 0 {
+		return fmt.Errorf("bad binary:%x", buf)
+	}
+	return nil
+}
+
 func (sec *SecretKey) SetArray(v []uint64) error {
 	if len(v) != 4 {
 		return fmt.Errorf("bad size", len(v))
@@ -179,9 +218,52 @@ func (pub *PublicKey) SetStr(s string) error {
 	return nil
 }
 
+// Serialize returns the compressed binary of BLS_PUBLICKEY_SERIALIZED_SIZE bytes
+func (pub *PublicKey) Serialize() []byte {
+	buf := make([]byte, C.BLS_PUBLICKEY_SERIALIZED_SIZE)
+	n := C.blsPublicKeySerialize(pub.getPointer(), getUint8Pointer(buf), C.size_t(len(buf)))
+	if n == 0 {
+		panic("implementation err. size of buf is small")
+	}
+	return buf
+}
+
+// SerializeUncompressed returns the uncompressed binary of BLS_PUBLICKEY_UNCOMPRESSED_SIZE bytes
+// which is larger than Serialize but faster to deserialize
+func (pub *PublicKey) SerializeUncompressed() []byte {
+	buf := make([]byte, C.BLS_PUBLICKEY_UNCOMPRESSED_SIZE)
+	n := C.blsPublicKeySerializeUncompressed(pub.getPointer(), getUint8Pointer(buf), C.size_t(len(buf)))
+	if n == 0 {
+		panic("implementation err. size of buf is small")
+	}
+	return buf
+}
+
+// Deserialize sets the binary made by Serialize or SerializeUncompressed
+func (pub *PublicKey) Deserialize(buf []byte) error {
+	err := C.blsPublicKeyDeserialize(pub.getPointer(), getUint8Pointer(buf), C.size_t(len(buf)))
+	if err > 0 {
+		return fmt.Errorf("bad binary:%x", buf)
+	}
+	return nil
+}
+
 func (pub *PublicKey) Add(rhs *PublicKey) {
 	C.blsPublicKeyAdd(pub.getPointer(), rhs.getPointer())
 }
+
+// Aggregate sets pub to the sum of pubVec
+func (pub *PublicKey) Aggregate(pubVec []PublicKey) error {
+	var p *C.blsPublicKey
+	if len(pubVec) > 0 {
+		p = pubVec[0].getPointer()
+	}
+	if C.blsPublicKeyAggregate(pub.getPointer(), p, C.size_t(len(pubVec))) != 0 {
+		return fmt.Errorf("blsPublicKeyAggregate failed")
+	}
+	return nil
+}
+
 func (pub *PublicKey) Set(msk []PublicKey, id *Id) {
 	C.blsPublicKeySet(pub.getPointer(), msk[0].getPointer(), C.size_t(len(msk)), id.getPointer())
 }
@@ -216,6 +298,36 @@ func (sign *Sign) SetStr(s string) error {
 	return nil
 }
 
+// Serialize returns the compressed binary of BLS_SIGN_SERIALIZED_SIZE bytes
+func (sign *Sign) Serialize() []byte {
+	buf := make([]byte, C.BLS_SIGN_SERIALIZED_SIZE)
+	n := C.blsSignSerialize(sign.getPointer(), getUint8Pointer(buf), C.size_t(len(buf)))
+	if n == 0 {
+		panic("implementation err. size of buf is small")
+	}
+	return buf
+}
+
+// SerializeUncompressed returns the uncompressed binary of BLS_SIGN_UNCOMPRESSED_SIZE bytes
+// which is larger than Serialize but faster to deserialize
+func (sign *Sign) SerializeUncompressed() []byte {
+	buf := make([]byte, C.BLS_SIGN_UNCOMPRESSED_SIZE)
+	n := C.blsSignSerializeUncompressed(sign.getPointer(), getUint8Pointer(buf), C.size_t(len(buf)))
+	if n == 0 {
+		panic("implementation err. size of buf is small")
+	}
+	return buf
+}
+
+// Deserialize sets the binary made by Serialize or SerializeUncompressed
+func (sign *Sign) Deserialize(buf []byte) error {
+	err := C.blsSignDeserialize(sign.getPointer(), getUint8Pointer(buf), C.size_t(len(buf)))
+	if err > 0 {
+		return fmt.Errorf("bad binary:%x", buf)
+	}
+	return nil
+}
+
 func (sec *SecretKey) GetPublicKey() (pub *PublicKey) {
 	pub = new(PublicKey)
 	C.blsSecretKeyGetPublicKey(sec.getPointer(), pub.getPointer())
@@ -223,24 +335,103 @@ func (sec *SecretKey) GetPublicKey() (pub *PublicKey) {
 }
 
 func (sec *SecretKey) Sign(m string) (sign *Sign) {
+	return sec.SignBytes([]byte(m))
+}
+
+// getBytePointer returns nil for an empty m
+func getBytePointer(m []byte) *C.char {
+	if len(m) == 0 {
+		return nil
+	}
+	return (*C.char)(unsafe.Pointer(&m[0]))
+}
+
+// getUint8Pointer returns nil for an empty buf
+func getUint8Pointer(buf []byte) *C.uint8_t {
+	if len(buf) == 0 {
+		return nil
+	}
+	return (*C.uint8_t)(unsafe.Pointer(&buf[0]))
+}
+
+// SignBytes signs m without copying it
+func (sec *SecretKey) SignBytes(m []byte) (sign *Sign) {
 	sign = new(Sign)
-	buf := []byte(m)
-	C.blsSecretKeySign(sec.getPointer(), sign.getPointer(), (*C.char)(unsafe.Pointer(&buf[0])), C.size_t(len(buf)))
+	C.blsSecretKeySign(sec.getPointer(), sign.getPointer(), getBytePointer(m), C.size_t(len(m)))
 	return sign
 }
 
 func (sign *Sign) Add(rhs *Sign) {
 	C.blsSignAdd(sign.getPointer(), rhs.getPointer())
 }
+
+// Aggregate sets sign to the sum of signVec
+func (sign *Sign) Aggregate(signVec []Sign) error {
+	var p *C.blsSign
+	if len(signVec) > 0 {
+		p = signVec[0].getPointer()
+	}
+	if C.blsSignAggregate(sign.getPointer(), p, C.size_t(len(signVec))) != 0 {
+		return fmt.Errorf("blsSignAggregate failed")
+	}
+	return nil
+}
+
 func (sign *Sign) Recover(signVec []Sign, idVec []Id) {
 	C.blsSignRecover(sign.getPointer(), signVec[0].getPointer(), idVec[0].getPointer(), C.size_t(len(signVec)))
 }
 
 func (sign *Sign) Verify(pub *PublicKey, m string) bool {
-	buf := []byte(m)
-	return C.blsSignVerify(sign.getPointer(), pub.getPointer(), (*C.char)(unsafe.Pointer(&buf[0])), C.size_t(len(buf))) == 1
+	return sign.VerifyBytes(pub, []byte(m))
+}
+
+// VerifyBytes verifies sign with pub and m without copying m
+func (sign *Sign) VerifyBytes(pub *PublicKey, m []byte) bool {
+	return C.blsSignVerify(sign.getPointer(), pub.getPointer(), getBytePointer(m), C.size_t(len(m))) == 1
 }
 
 func (sign *Sign) VerifyPop(pub *PublicKey) bool {
 	return C.blsSignVerifyPop(sign.getPointer(), pub.getPointer()) == 1
 }
+
+// VerifyAggregate verifies sign aggregated from the signs of msgVec[i] by pubVec[i] without copying msgVec
+func (sign *Sign) VerifyAggregate(pubVec []PublicKey, msgVec []string) bool {
+	n := len(pubVec)
+	if n == 0 || n != len(msgVec) {
+		return false
+	}
+	// C reads the messages through mVec in Go memory, so they must be pinned
+	var pinner runtime.Pinner
+	defer pinner.Unpin()
+	mVec := make([]*C.char, n)
+	mSizeVec := make([]C.size_t, n)
+	for i := 0; i < n; i++ {
+		if len(msgVec[i]) > 0 {
+			p := unsafe.StringData(msgVec[i])
+			pinner.Pin(p)
+			mVec[i] = (*C.char)(unsafe.Pointer(p))
+		}
+		mSizeVec[i] = C.size_t(len(msgVec[i]))
+	}
+	return C.blsSignVerifyAggregate(sign.getPointer(), pubVec[0].getPointer(), &mVec[0], &mSizeVec[0], C.size_t(n)) == 1
+}
+
+// VerifyAggregateBytes is VerifyAggregate for the messages of []byte
+func (sign *Sign) VerifyAggregateBytes(pubVec []PublicKey, msgVec [][]byte) bool {
+	n := len(pubVec)
+	if n == 0 || n != len(msgVec) {
+		return false
+	}
+	var pinner runtime.Pinner
+	defer pinner.Unpin()
+	mVec := make([]*C.char, n)
+	mSizeVec := make([]C.size_t, n)
+	for i := 0; i < n; i++ {
+		if len(msgVec[i]) > 0 {
+			pinner.Pin(&msgVec[i][0])
+			mVec[i] = getBytePointer(msgVec[i])
+		}
+		mSizeVec[i] = C.size_t(len(msgVec[i]))
+	}
+	return C.blsSignVerifyAggregate(sign.getPointer(), pubVec[0].getPointer(), &mVec[0], &mSizeVec[0], C.size_t(n)) == 1
+}
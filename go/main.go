@@ -110,6 +110,113 @@ func testPop() {
 	sec.Init()
 	verifyTrue(!pop.VerifyPop(sec.GetPublicKey()))
 }
+func testVerifyAggregate() {
+	fmt.Println("testVerifyAggregate")
+	n := 10
+	pubVec := make([]bls.PublicKey, n)
+	msgVec := make([]string, n)
+	var agg bls.Sign
+	for i := 0; i < n; i++ {
+		var sec bls.SecretKey
+		sec.Init()
+		pubVec[i] = *sec.GetPublicKey()
+		msgVec[i] = fmt.Sprintf("aggregate %d", i)
+		sign := sec.Sign(msgVec[i])
+		if i == 0 {
+			agg = *sign
+		} else {
+			agg.Add(sign)
+		}
+	}
+	verifyTrue(agg.VerifyAggregate(pubVec, msgVec))
+	bufVec := make([][]byte, n)
+	for i := 0; i < n; i++ {
+		bufVec[i] = []byte(msgVec[i])
+	}
+	verifyTrue(agg.VerifyAggregateBytes(pubVec, bufVec))
+	msgVec[0] = msgVec[1]
+	verifyTrue(!agg.VerifyAggregate(pubVec, msgVec))
+	bufVec[0] = bufVec[1]
+	verifyTrue(!agg.VerifyAggregateBytes(pubVec, bufVec))
+}
+
+func testSignBytes() {
+	fmt.Println("testSignBytes")
+	var sec bls.SecretKey
+	sec.Init()
+	pub := sec.GetPublicKey()
+	m := []byte("sign bytes")
+	sign := sec.SignBytes(m)
+	verifyTrue(sign.String() == sec.Sign(string(m)).String())
+	verifyTrue(sign.VerifyBytes(pub, m))
+	verifyTrue(!sign.VerifyBytes(pub, m[1:]))
+	sign = sec.SignBytes(nil)
+	verifyTrue(sign.Verify(pub, ""))
+}
+
+func testAggregate() {
+	fmt.Println("testAggregate")
+	n := 10
+	m := "aggregate"
+	pubVec := make([]bls.PublicKey, n)
+	signVec := make([]bls.Sign, n)
+	var sumPub bls.PublicKey
+	var sumSign bls.Sign
+	for i := 0; i < n; i++ {
+		var sec bls.SecretKey
+		sec.Init()
+		pubVec[i] = *sec.GetPublicKey()
+		signVec[i] = *sec.Sign(m)
+		if i == 0 {
+			sumPub = pubVec[0]
+			sumSign = signVec[0]
+		} else {
+			sumPub.Add(&pubVec[i])
+			sumSign.Add(&signVec[i])
+		}
+	}
+	var pub bls.PublicKey
+	var sign bls.Sign
+	verifyTrue(pub.Aggregate(pubVec) == nil)
+	verifyTrue(sign.Aggregate(signVec) == nil)
+	verifyTrue(pub.String() == sumPub.String())
+	verifyTrue(sign.String() == sumSign.String())
+	verifyTrue(sign.Verify(&pub, m))
+}
+
+func testSerialize() {
+	fmt.Println("testSerialize")
+	var id bls.Id
+	id.Set([]uint64{4, 3, 2, 1})
+	var id2 bls.Id
+	verifyTrue(id2.Deserialize(id.Serialize()) == nil)
+	verifyTrue(id.String() == id2.String())
+
+	var sec bls.SecretKey
+	sec.Init()
+	var sec2 bls.SecretKey
+	verifyTrue(sec2.Deserialize(sec.Serialize()) == nil)
+	verifyTrue(sec.String() == sec2.String())
+
+	pub := sec.GetPublicKey()
+	var pub2 bls.PublicKey
+	verifyTrue(pub2.Deserialize(pub.Serialize()) == nil)
+	verifyTrue(pub.String() == pub2.String())
+
+	m := "serialize"
+	sign := sec.Sign(m)
+	var sign2 bls.Sign
+	buf := sign.Serialize()
+	verifyTrue(sign2.Deserialize(buf) == nil)
+	verifyTrue(sign2.Verify(&pub2, m))
+	verifyTrue(sign2.Deserialize(buf[1:]) != nil)
+	verifyTrue(sign2.Deserialize(nil) != nil)
+	verifyTrue(pub2.Deserialize(pub.SerializeUncompressed()) == nil)
+	verifyTrue(pub.String() == pub2.String())
+	verifyTrue(sign2.Deserialize(sign.SerializeUncompressed()) == nil)
+	verifyTrue(sign.String() == sign2.String())
+}
+
 func main() {
 	fmt.Println("init")
 	bls.Init()
@@ -151,6 +258,10 @@ func main() {
 	testAdd()
 	testSign()
 	testPop()
+	testVerifyAggregate()
+	testSignBytes()
+	testSerialize()
+	testAggregate()
 
 	// put memory status
 	runtime.GC()
@@ -8,6 +8,7 @@
 */
 #include <vector>
 #include <string>
+#include <functional>
 #include <iosfwd>
 #include <stdint.h>
 
@@ -19,6 +20,15 @@ struct SecretKey;
 struct PublicKey;
 struct Sign;
 struct Id;
+struct PreparedPublicKey;
+struct AggregatePublicKeyCache;
+struct ThreadPool;
+struct MessageHasher;
+struct LagrangeContext;
+struct PublicKeyRegistry;
+struct AffinePublicKey;
+struct AffineSign;
+struct CommitteeAggregator;
 
 } // bls::impl
 
@@ -39,10 +49,114 @@ struct Id;
 */
 void init();
 
+/*
+	set the random generator of SecretKey::init (getMasterSecretKey), the polynomials of the shares and verifyBatch
+	readFunc(self, buf, bufSize) fills buf[0, bufSize) with cryptographically secure random bytes
+	and returns bufSize ; an exception is thrown if it returns the other value
+	it must be thread safe if several threads make keys
+	setRandFunc(0, 0) restores the default, which is ChaCha20 of each thread
+	seeded by getrandom() (/dev/urandom, BCryptGenRandom) and the process id and reseeded every 1MiB and after fork()
+	@note it is not thread safe ; call it before the other threads make keys
+*/
+typedef size_t (*ReadRandFunc)(void *self, void *buf, size_t bufSize);
+void setRandFunc(void *self, ReadRandFunc readFunc);
+
+/*
+	cache H(m) of at most capacity messages keyed by SHA-256 of m
+	sign and verify use it if capacity > 0 (default 0 ; disabled)
+	the least recently used entry is removed if it overflows
+	it is thread safe
+*/
+void setHashCacheCapacity(size_t capacity);
+
+struct HashCacheStats {
+	size_t capacity;
+	size_t size;
+	size_t hitNum;
+	size_t missNum;
+};
+
+void getHashCacheStats(HashCacheStats& stats);
+/*
+	remove all entries and reset the counters
+*/
+void clearHashCache();
+
+const size_t maxPublicKeyTableWindow = 12;
+/*
+	set the window bit size w of the fixed-base table of Q for SecretKey::getPublicKey
+	the table has ceil(256 / w) (2^w - 1) points of G2 and getPublicKey needs ceil(256 / w) additions
+	w = 4 (default) uses the table generated at build time
+	1 <= w <= maxPublicKeyTableWindow
+	@note it is not thread safe ; call it before the other threads use getPublicKey
+*/
+void setPublicKeyTableWindow(size_t w);
+size_t getPublicKeyTableWindow();
+/*
+	return the number of bytes of the table
+*/
+size_t getPublicKeyTableMemorySize();
+
+/*
+	operations counted by the library built with -DBLS_ENABLE_STATS
+	each counter has the number of calls, the total time and the histogram of the time
+	an operation includes the operations called by it, e.g. StatsHashToG1 includes StatsMapToG1
+*/
+enum StatsOp {
+	StatsMillerLoop, // Miller loop of a pairing
+	StatsFinalExp, // final exponentiation of a pairing or a product of them
+	StatsG1Mul, // scalar multiplication of G1
+	StatsG2Mul, // scalar multiplication of G2 including SecretKey::getPublicKey
+	StatsMulVec, // multi-scalar multiplication of G1 or G2 such as recover
+	StatsHashToG1, // H(m) including the hash cache
+	StatsMapToG1, // map-to-curve of a digest
+	StatsSerialize, // serialize() of Id, SecretKey, PublicKey and Sign
+	StatsDeserialize, // deserialize() of them including the check of the point
+	StatsGetStr, // operator<< of them (getStr of the C API)
+	StatsSetStr, // operator>> of them (setStr of the C API)
+	StatsLagrangeInv, // inversion of the Lagrange coefficients
+	StatsNormalize, // inversion to normalize points ; one for all the points of normalizeVec
+	statsOpNum
+};
+
+/*
+	histogram[i] is the number of calls which take [2^i, 2^(i+1)) nsec
+	(histogram[0] includes 0 nsec and histogram[statsHistogramSize - 1] includes the longer time)
+*/
+const size_t statsHistogramSize = 32;
+
+struct StatsCounter {
+	uint64_t count;
+	uint64_t totalNsec;
+	uint64_t histogram[statsHistogramSize];
+};
+
+/*
+	return true if the library is built with -DBLS_ENABLE_STATS
+	otherwise the counters are always zero and cost nothing
+*/
+bool isStatsEnabled();
+const char *getStatsOpName(StatsOp op);
+/*
+	counterVec[op] = the counter of op for 0 <= op < statsOpNum
+	it is thread safe but the snapshot is not atomic while the other threads run
+*/
+void getStats(StatsCounter *counterVec);
+void resetStats();
+
 class SecretKey;
 class PublicKey;
 class Sign;
 class Id;
+class PreparedPublicKey;
+class AggregatePublicKeyCache;
+class ThreadPool;
+class MessageHasher;
+class LagrangeContext;
+class PublicKeyRegistry;
+class AffinePublicKey;
+class AffineSign;
+class CommitteeAggregator;
 
 /*
 	the value of secretKey and Id must be less than
@@ -51,6 +165,42 @@ class Id;
 */
 const size_t keySize = 4;
 
+/*
+	the number of bytes written by serialize()
+	Id, SecretKey ; 32-byte little endian
+	PublicKey, Sign ; compressed x (32-byte little endian for each element of Fp)
+	where the top two bits of the last byte are the flags of the sign of y and the point at infinity
+*/
+const size_t idSerializedSize = 32;
+const size_t secretKeySerializedSize = 32;
+const size_t publicKeySerializedSize = 64;
+const size_t signSerializedSize = 32;
+/*
+	the number of bytes written by serialize(out, PointUncompressed)
+	the affine (x, y) where x has the both flags and (0, 0) is the point at infinity
+	deserialize() reads both formats by the flags
+*/
+const size_t publicKeyUncompressedSize = 128;
+const size_t signUncompressedSize = 64;
+
+enum PointFormat {
+	PointCompressed, // smaller ; deserialize needs a square root
+	PointUncompressed // faster to deserialize
+};
+
+/*
+	mode of PublicKey::deserialize
+	DeserializeChecked ; check that the point is in G2 (default)
+	DeserializeTrusted ; skip the check of the order of the point and
+	the check that the uncompressed point is on the curve
+	use DeserializeTrusted only for the data made by serialize() of a trusted source
+	such as a local signed database, and never for the input from the network
+*/
+enum DeserializeMode {
+	DeserializeChecked,
+	DeserializeTrusted
+};
+
 typedef std::vector<SecretKey> SecretKeyVec;
 typedef std::vector<PublicKey> PublicKeyVec;
 typedef std::vector<Sign> SignVec;
@@ -69,6 +219,15 @@ public:
 	bool operator!=(const Id& rhs) const { return !(*this == rhs); }
 	friend std::ostream& operator<<(std::ostream& os, const Id& id);
 	friend std::istream& operator>>(std::istream& is, Id& id);
+	/*
+		write idSerializedSize bytes to out
+	*/
+	void serialize(uint8_t *out) const;
+	/*
+		set the value serialized in buf[0, bufSize)
+		return false if bufSize != idSerializedSize or buf is not a valid value
+	*/
+	bool deserialize(const uint8_t *buf, size_t bufSize);
 	bool isZero() const;
 	/*
 		set p[0, .., keySize)
@@ -92,6 +251,15 @@ public:
 	bool operator!=(const SecretKey& rhs) const { return !(*this == rhs); }
 	friend std::ostream& operator<<(std::ostream& os, const SecretKey& sec);
 	friend std::istream& operator>>(std::istream& is, SecretKey& sec);
+	/*
+		write secretKeySerializedSize bytes to out
+	*/
+	void serialize(uint8_t *out) const;
+	/*
+		set the value serialized in buf[0, bufSize)
+		return false if bufSize != secretKeySerializedSize or buf is not a valid value
+	*/
+	bool deserialize(const uint8_t *buf, size_t bufSize);
 	/*
 		initialize secretKey with random number and set id = 0
 	*/
@@ -103,6 +271,12 @@ public:
 	void set(const uint64_t *p);
 	void getPublicKey(PublicKey& pub) const;
 	void sign(Sign& sign, const std::string& m) const;
+	void sign(Sign& sign, const void *m, size_t mSize) const;
+	/*
+		sign the message given to h by update()
+		h is reset
+	*/
+	void sign(Sign& sign, MessageHasher& h) const;
 	/*
 		make Pop(Proof of Possesion)
 		pop = prv.sign(pub)
@@ -123,6 +297,10 @@ public:
 		recover secretKey from k secVec
 	*/
 	void recover(const SecretKeyVec& secVec, const IdVec& idVec);
+	/*
+		recover with the precomputed tables for the ids 1, ..., n
+	*/
+	void recover(const SecretKeyVec& secVec, const IdVec& idVec, const LagrangeContext& ctx);
 	/*
 		add secret key
 	*/
@@ -134,6 +312,7 @@ public:
 	*/
 	void set(const SecretKey *msk, size_t k, const Id& id);
 	void recover(const SecretKey *secVec, const Id *idVec, size_t n);
+	void recover(const SecretKey *secVec, const Id *idVec, size_t n, const LagrangeContext& ctx);
 };
 
 /*
@@ -144,6 +323,10 @@ class PublicKey {
 	friend class SecretKey;
 	friend class Sign;
 	template<class T, class G> friend struct WrapArray;
+	friend class PreparedPublicKey;
+	friend class AggregatePublicKeyCache;
+	friend class CommitteeAggregator;
+	friend void mulVec(PublicKey& out, const PublicKey *pubVec, const SecretKey *coeffVec, size_t n);
 	impl::PublicKey& getInner() { return *reinterpret_cast<impl::PublicKey*>(self_); }
 	const impl::PublicKey& getInner() const { return *reinterpret_cast<const impl::PublicKey*>(self_); }
 public:
@@ -152,6 +335,17 @@ public:
 	bool operator!=(const PublicKey& rhs) const { return !(*this == rhs); }
 	friend std::ostream& operator<<(std::ostream& os, const PublicKey& pub);
 	friend std::istream& operator>>(std::istream& is, PublicKey& pub);
+	/*
+		write publicKeySerializedSize bytes to out
+		or publicKeyUncompressedSize bytes if format = PointUncompressed
+	*/
+	void serialize(uint8_t *out, PointFormat format = PointCompressed) const;
+	/*
+		set the value serialized in buf[0, bufSize)
+		return false if bufSize is not the size of the format or buf is not a valid value
+		the checks of the point are skipped if mode = DeserializeTrusted
+	*/
+	bool deserialize(const uint8_t *buf, size_t bufSize, DeserializeMode mode = DeserializeChecked);
 	/*
 		set public for id from mpk
 	*/
@@ -163,14 +357,82 @@ public:
 		recover publicKey from k pubVec
 	*/
 	void recover(const PublicKeyVec& pubVec, const IdVec& idVec);
+	void recover(const PublicKeyVec& pubVec, const IdVec& idVec, const LagrangeContext& ctx);
 	/*
 		add public key
+		it is a mixed addition which is faster if rhs is normalized
 	*/
 	void add(const PublicKey& rhs);
+	/*
+		set the Jacobian coordinates (x, y, z) to (x/z^2, y/z^3, 1)
+	*/
+	void normalize();
+	/*
+		self = pubVec[0] + ... + pubVec[n - 1]
+		pubVec is normalized block by block with one inversion per block and added by mixed additions
+		then the sums of the blocks are added by a pairwise tree
+		the blocks are shared by the threads of pool if it is not NULL
+		it is much faster than calling add() n - 1 times
+	*/
+	void aggregate(const PublicKey *pubVec, size_t n, ThreadPool *pool = 0);
+	void aggregate(const std::vector<PublicKey>& pubVec, ThreadPool *pool = 0)
+	{
+		aggregate(pubVec.data(), pubVec.size(), pool);
+	}
+	/*
+		self = pubVec[0] + ... + pubVec[n - 1] by mixed additions
+		each thread of pool sums a part of pubVec if pool is not NULL
+	*/
+	void aggregate(const AffinePublicKey *pubVec, size_t n, ThreadPool *pool = 0);
 
 	// the following methods are for C api
 	void set(const PublicKey *mpk, size_t k, const Id& id);
 	void recover(const PublicKey *pubVec, const Id *idVec, size_t n);
+	void recover(const PublicKey *pubVec, const Id *idVec, size_t n, const LagrangeContext& ctx);
+};
+
+/*
+	affine coordinates (x, y) of sQ
+	it needs 2/3 of the memory of PublicKey which keeps the Jacobian coordinates (x, y, z)
+	(0, 0) is the point at infinity
+*/
+class AffinePublicKey {
+	uint64_t self_[4 * 2 * 2]; // 256-bit x 2 x 2
+	template<class T, class G> friend struct WrapArray;
+	impl::AffinePublicKey& getInner() { return *reinterpret_cast<impl::AffinePublicKey*>(self_); }
+	const impl::AffinePublicKey& getInner() const { return *reinterpret_cast<const impl::AffinePublicKey*>(self_); }
+public:
+	AffinePublicKey() : self_() {}
+	explicit AffinePublicKey(const PublicKey& pub) { set(pub); }
+	bool operator==(const AffinePublicKey& rhs) const;
+	bool operator!=(const AffinePublicKey& rhs) const { return !(*this == rhs); }
+	/*
+		it needs an inversion ; use toAffineVec for many keys
+	*/
+	void set(const PublicKey& pub);
+	void get(PublicKey& pub) const;
+};
+
+/*
+	sQ with the precomputed coefficients of the Miller loop
+	verify with it skips the line computation of sQ
+	it is worth keeping for a public key which verifies many signs
+*/
+class PreparedPublicKey {
+	impl::PreparedPublicKey *self_;
+	friend class Sign;
+public:
+	PreparedPublicKey();
+	explicit PreparedPublicKey(const PublicKey& pub);
+	PreparedPublicKey(const PreparedPublicKey& rhs);
+	PreparedPublicKey& operator=(const PreparedPublicKey& rhs);
+	~PreparedPublicKey();
+	void set(const PublicKey& pub);
+	void getPublicKey(PublicKey& pub) const;
+	/*
+		return the number of bytes used by this instance
+	*/
+	size_t getMemorySize() const;
 };
 
 /*
@@ -180,6 +442,7 @@ class Sign {
 	uint64_t self_[4 * 3]; // 256-bit x 3
 	friend class SecretKey;
 	template<class T, class G> friend struct WrapArray;
+	friend void mulVec(Sign& out, const Sign *signVec, const SecretKey *coeffVec, size_t n);
 	impl::Sign& getInner() { return *reinterpret_cast<impl::Sign*>(self_); }
 	const impl::Sign& getInner() const { return *reinterpret_cast<const impl::Sign*>(self_); }
 public:
@@ -188,24 +451,349 @@ public:
 	bool operator!=(const Sign& rhs) const { return !(*this == rhs); }
 	friend std::ostream& operator<<(std::ostream& os, const Sign& s);
 	friend std::istream& operator>>(std::istream& is, Sign& s);
+	/*
+		write signSerializedSize bytes to out
+		or signUncompressedSize bytes if format = PointUncompressed
+	*/
+	void serialize(uint8_t *out, PointFormat format = PointCompressed) const;
+	/*
+		set the value serialized in buf[0, bufSize)
+		return false if bufSize is not the size of the format or buf is not a valid value
+	*/
+	bool deserialize(const uint8_t *buf, size_t bufSize);
 	bool verify(const PublicKey& pub, const std::string& m) const;
+	bool verify(const PublicKey& pub, const void *m, size_t mSize) const;
+	bool verify(const PreparedPublicKey& ppub, const std::string& m) const;
+	bool verify(const PreparedPublicKey& ppub, const void *m, size_t mSize) const;
+	/*
+		verify with the message given to h by update()
+		h is reset
+	*/
+	bool verify(const PublicKey& pub, MessageHasher& h) const;
+	bool verify(const PreparedPublicKey& ppub, MessageHasher& h) const;
 	/*
 		verify self(pop) with pub
 	*/
 	bool verify(const PublicKey& pub) const;
+	/*
+		verify self(aggregated sign) of n signs made by pubVec[i] for msgVec[i]
+		e(Q, self) = prod_i e(pubVec[i], H(msgVec[i]))
+		return false if msgVec has the same message
+	*/
+	bool verifyAggregate(const PublicKey *pubVec, const std::string *msgVec, size_t n) const;
+	bool verifyAggregate(const PublicKeyVec& pubVec, const std::vector<std::string>& msgVec) const
+	{
+		if (pubVec.size() != msgVec.size()) return false;
+		return verifyAggregate(pubVec.data(), msgVec.data(), pubVec.size());
+	}
+	/*
+		msgVec[i] is msgSizeVec[i] bytes
+	*/
+	bool verifyAggregate(const PublicKey *pubVec, const char *const *msgVec, const size_t *msgSizeVec, size_t n) const;
 	/*
 		recover sign from k signVec
 	*/
 	void recover(const SignVec& signVec, const IdVec& idVec);
+	void recover(const SignVec& signVec, const IdVec& idVec, const LagrangeContext& ctx);
+	/*
+		set H(m) ; the sign of m by the secret key 1
+	*/
+	void setHashOf(const void *m, size_t mSize);
+	void setHashOf(const std::string& m) { setHashOf(m.data(), m.size()); }
 	/*
 		add signature
+		it is a mixed addition which is faster if rhs is normalized
 	*/
 	void add(const Sign& rhs);
+	/*
+		set the Jacobian coordinates (x, y, z) to (x/z^2, y/z^3, 1)
+	*/
+	void normalize();
+	/*
+		self = signVec[0] + ... + signVec[n - 1]
+		signVec is normalized block by block with one inversion per block and added by mixed additions
+		then the sums of the blocks are added by a pairwise tree
+		the blocks are shared by the threads of pool if it is not NULL
+		it is much faster than calling add() n - 1 times
+	*/
+	void aggregate(const Sign *signVec, size_t n, ThreadPool *pool = 0);
+	void aggregate(const std::vector<Sign>& signVec, ThreadPool *pool = 0)
+	{
+		aggregate(signVec.data(), signVec.size(), pool);
+	}
+	/*
+		self = signVec[0] + ... + signVec[n - 1] by mixed additions
+		each thread of pool sums a part of signVec if pool is not NULL
+	*/
+	void aggregate(const AffineSign *signVec, size_t n, ThreadPool *pool = 0);
 
 	// the following methods are for C api
 	void recover(const Sign* signVec, const Id *idVec, size_t n);
+	void recover(const Sign* signVec, const Id *idVec, size_t n, const LagrangeContext& ctx);
+};
+
+/*
+	affine coordinates (x, y) of s H(m)
+	it needs 2/3 of the memory of Sign
+	(0, 0) is the point at infinity
+*/
+class AffineSign {
+	uint64_t self_[4 * 2]; // 256-bit x 2
+	template<class T, class G> friend struct WrapArray;
+	impl::AffineSign& getInner() { return *reinterpret_cast<impl::AffineSign*>(self_); }
+	const impl::AffineSign& getInner() const { return *reinterpret_cast<const impl::AffineSign*>(self_); }
+public:
+	AffineSign() : self_() {}
+	explicit AffineSign(const Sign& sign) { set(sign); }
+	bool operator==(const AffineSign& rhs) const;
+	bool operator!=(const AffineSign& rhs) const { return !(*this == rhs); }
+	/*
+		it needs an inversion ; use toAffineVec for many signs
+	*/
+	void set(const Sign& sign);
+	void get(Sign& sign) const;
+};
+
+/*
+	precomputed tables to get the Lagrange coefficients for the ids 1, ..., n
+	recover with it needs no inversion and
+	min(k, n - k) multiplications per coefficient for k shares
+	an id out of [1, n] throws an exception
+*/
+class LagrangeContext {
+	impl::LagrangeContext *self_;
+	friend class SecretKey;
+	friend class PublicKey;
+	friend class Sign;
+	LagrangeContext(const LagrangeContext&);
+	void operator=(const LagrangeContext&);
+public:
+	explicit LagrangeContext(size_t n);
+	~LagrangeContext();
+	size_t getN() const;
+};
+
+/*
+	incremental SHA-256 of a message for sign and verify
+	feed a large message by update() chunk by chunk without copying all of it
+	sign(sig, h) is equal to sign(sig, m) if m is given to h by update()
+*/
+class MessageHasher {
+	impl::MessageHasher *self_;
+	friend class SecretKey;
+	friend class Sign;
+	MessageHasher(const MessageHasher&);
+	void operator=(const MessageHasher&);
+public:
+	MessageHasher();
+	~MessageHasher();
+	void update(const void *buf, size_t bufSize);
+	void update(const std::string& m) { update(m.data(), m.size()); }
+	/*
+		discard the message given by update()
+	*/
+	void reset();
 };
 
+/*
+	read-only registry of public keys in a file mapped to memory
+	the file made by build() is
+	"blsPubK1" (8 bytes), n (8-byte little endian), n public keys written by PublicKey::serialize
+	a public key is deserialized on access and kept in a cache of at most cacheSize keys
+	it is thread safe
+*/
+class PublicKeyRegistry {
+	impl::PublicKeyRegistry *self_;
+	PublicKeyRegistry(const PublicKeyRegistry&);
+	void operator=(const PublicKeyRegistry&);
+public:
+	/*
+		map the file at path
+		DeserializeTrusted skips the check of the order of each key
+		which build() has checked if the file is not modified after that
+		throw if the file is not a registry
+	*/
+	explicit PublicKeyRegistry(const std::string& path, DeserializeMode mode = DeserializeChecked, size_t cacheSize = 1024);
+	~PublicKeyRegistry();
+	/*
+		return the number of public keys
+	*/
+	size_t size() const;
+	/*
+		pub = the idx-th public key
+		throw if idx >= size() or the key is invalid
+	*/
+	void get(PublicKey& pub, size_t idx) const;
+	/*
+		make the file at path from pubVec[0, n)
+		each key is serialized and checked to be in G2 on pool if it is not NULL
+		the keys are written to path + ".tmp" which is renamed to path at the end
+		throw if a key is invalid or the file can't be written
+	*/
+	static void build(const std::string& path, const PublicKey *pubVec, size_t n, ThreadPool *pool = 0);
+	/*
+		make the file at path from the text file at textPath
+		which has public keys written by operator<< separated by white spaces
+	*/
+	static void convertFromText(const std::string& path, const std::string& textPath, ThreadPool *pool = 0);
+};
+
+/*
+	thread pool with work stealing for the bulk operations
+	threadNum is the number of threads including the thread calling run()
+	threadNum = 0 means std::thread::hardware_concurrency()
+*/
+class ThreadPool {
+	impl::ThreadPool *self_;
+	ThreadPool(const ThreadPool&);
+	void operator=(const ThreadPool&);
+public:
+	explicit ThreadPool(size_t threadNum = 0);
+	~ThreadPool();
+	size_t getThreadNum() const;
+	/*
+		split [0, n) into ranges of grainSize and call f(begin, end) for each of them in parallel
+		return after all of them finish
+		the first exception thrown by f is rethrown
+		f may call run() of this pool (e.g. verifyBatch(..., pool)) ; the inner run() calls f on the thread
+		but f must not wait for the other thread which calls run() of this pool
+	*/
+	void run(size_t n, const std::function<void(size_t begin, size_t end)>& f, size_t grainSize = 1);
+};
+
+/*
+	verify n triples (signVec[i], pubVec[i], msgVec[i]) at once
+	by a random linear combination
+	e(Q, sum_i r_i sign_i) = prod_i e(pub_i, r_i H(m_i))
+	r_i is a random 64-bit integer ; an invalid batch passes with probability 2^-64
+	return true if all of them are valid
+	if badIdxVec is not NULL and the batch fails then
+	badIdxVec is set to the indices of the invalid triples
+	the Miller loops and the scalar multiplications run on pool if it is not NULL
+*/
+bool verifyBatch(const Sign *signVec, const PublicKey *pubVec, const std::string *msgVec, size_t n, std::vector<size_t> *badIdxVec = 0, ThreadPool *pool = 0);
+/*
+	msgVec[i] is msgSizeVec[i] bytes
+*/
+bool verifyBatch(const Sign *signVec, const PublicKey *pubVec, const char *const *msgVec, const size_t *msgSizeVec, size_t n, std::vector<size_t> *badIdxVec = 0, ThreadPool *pool = 0);
+
+/*
+	the following bulk operations run on pool if it is not NULL
+*/
+/*
+	signVec[i] = sec.sign(msgVec[i]) for 0 <= i < n
+*/
+void signBatch(Sign *signVec, const SecretKey& sec, const std::string *msgVec, size_t n, ThreadPool *pool = 0);
+void signBatch(Sign *signVec, const SecretKey& sec, const char *const *msgVec, const size_t *msgSizeVec, size_t n, ThreadPool *pool = 0);
+/*
+	secVec[i].getPublicKey(pubVec[i]) for 0 <= i < n
+*/
+void getPublicKeyBatch(PublicKey *pubVec, const SecretKey *secVec, size_t n, ThreadPool *pool = 0);
+/*
+	out[i].set(msk, idVec[i]) for 0 <= i < n
+	a run of m consecutive ids (e.g. 1, 2, ..., n) longer than k = msk.size()
+	costs k evaluations and (m - k)(k - 1) additions by the differences
+*/
+void deriveSecretShares(const SecretKeyVec& msk, const Id *idVec, size_t n, SecretKey *out, ThreadPool *pool = 0);
+/*
+	out[i].set(mpk, idVec[i]) for 0 <= i < n
+	the same as deriveSecretShares, then
+	n shares for the ids 1, ..., n cost about n k additions of G2 instead of n k multiplications
+*/
+void derivePublicShares(const PublicKeyVec& mpk, const Id *idVec, size_t n, PublicKey *out, ThreadPool *pool = 0);
+
+/*
+	multi-scalar multiplication by Pippenger's bucket method
+	out = sum_i coeffVec[i] signVec[i] (resp. pubVec[i]) for 0 <= i < n
+	it is much faster than n scalar multiplications for large n
+*/
+void mulVec(Sign& out, const Sign *signVec, const SecretKey *coeffVec, size_t n);
+void mulVec(PublicKey& out, const PublicKey *pubVec, const SecretKey *coeffVec, size_t n);
+
+/*
+	normalize pubVec[0, n) (resp. signVec) with one inversion per thread (Montgomery's trick)
+	then the additions with them are mixed additions
+*/
+void normalizeVec(PublicKey *pubVec, size_t n, ThreadPool *pool = 0);
+void normalizeVec(Sign *signVec, size_t n, ThreadPool *pool = 0);
+/*
+	out[i] = the affine coordinates of pubVec[i] (resp. signVec[i]) for i in [0, n)
+	with one inversion per thread
+*/
+void toAffineVec(AffinePublicKey *out, const PublicKey *pubVec, size_t n, ThreadPool *pool = 0);
+void toAffineVec(AffineSign *out, const Sign *signVec, size_t n, ThreadPool *pool = 0);
+
+/*
+	cache of the aggregate public keys of signer sets
+	the least recently used entry is removed if the number of entries exceeds maxSize
+	it is thread safe
+*/
+class AggregatePublicKeyCache {
+	impl::AggregatePublicKeyCache *self_;
+	AggregatePublicKeyCache(const AggregatePublicKeyCache&);
+	void operator=(const AggregatePublicKeyCache&);
+public:
+	explicit AggregatePublicKeyCache(size_t maxSize = 1024);
+	~AggregatePublicKeyCache();
+	/*
+		agg = pubVec[0] + ... + pubVec[n - 1]
+		the key is SHA-256 of the serialized pubVec[0, n)
+		a copy of pubVec is normalized with one inversion for the key and for the sum,
+		so a hit costs the same inversion as a miss and no additions
+		return true if agg is found in the cache
+	*/
+	bool get(PublicKey& agg, const PublicKey *pubVec, size_t n);
+	/*
+		use key (e.g. an id of the committee) instead of SHA-256 of pubVec[0, n)
+	*/
+	bool get(PublicKey& agg, const std::string& key, const PublicKey *pubVec, size_t n);
+	size_t size() const;
+	void clear();
+	/*
+		agg = pubVec[0] + ... + pubVec[n - 1]
+		by mixed additions after normalizing pubVec with one inversion
+		each thread of pool sums a part of pubVec if pool is not NULL
+	*/
+	static void aggregate(PublicKey& agg, const PublicKey *pubVec, size_t n, ThreadPool *pool = 0);
+};
+
+/*
+	aggregate public keys of the subsets of a fixed committee given by bitmaps
+	the sum of the committee, and the keys and the sums of the blocks of blockSize keys are kept
+	the subset is made from 0 or from the sum of the committee whichever needs fewer additions
+	and each block is given by the present keys or by its sum and the absent keys
+	e.g. about 6 additions per 64 keys for 90% participation instead of 58
+	it is thread safe
+*/
+class CommitteeAggregator {
+	impl::CommitteeAggregator *self_;
+	CommitteeAggregator(const CommitteeAggregator&);
+	void operator=(const CommitteeAggregator&);
+public:
+	explicit CommitteeAggregator(const PublicKeyVec& pubVec, size_t blockSize = 64);
+	~CommitteeAggregator();
+	/*
+		return the number of the members
+	*/
+	size_t size() const;
+	/*
+		agg = sum of pubVec[i] for i such that (bitmap[i / 8] >> (i % 8)) & 1
+		bitmapSize must be (size() + 7) / 8 and the unused bits must be zero
+		return the number of additions and subtractions
+		throw if bitmap is bad
+	*/
+	size_t aggregate(PublicKey& agg, const uint8_t *bitmap, size_t bitmapSize) const;
+};
+
+/*
+	verify sign aggregated from n signs for the same message m
+	e(Q, sign) = e(sum_i pubVec[i], H(m))
+	@note pubVec[i] must be verified by PoP to avoid the rogue key attack
+	if cache is not NULL then the aggregate public key is looked up in it
+*/
+bool fastAggregateVerify(const Sign& sign, const PublicKey *pubVec, size_t n, const std::string& m, AggregatePublicKeyCache *cache = 0);
+bool fastAggregateVerify(const Sign& sign, const PublicKey *pubVec, size_t n, const void *m, size_t mSize, AggregatePublicKeyCache *cache = 0);
+
 /*
 	make master public key [s_0 Q, ..., s_{k-1} Q] from msk
 */
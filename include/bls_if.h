@@ -30,7 +30,32 @@ typedef struct {
 	uint64_t buf[4 * 3];
 } blsSign;
 
+/*
+	the number of bytes of blsXSerialize
+*/
+#define BLS_ID_SERIALIZED_SIZE 32
+#define BLS_SECRETKEY_SERIALIZED_SIZE 32
+#define BLS_PUBLICKEY_SERIALIZED_SIZE 64
+#define BLS_SIGN_SERIALIZED_SIZE 32
+/*
+	the number of bytes of blsXSerializeUncompressed
+	blsXDeserialize reads both formats
+*/
+#define BLS_PUBLICKEY_UNCOMPRESSED_SIZE 128
+#define BLS_SIGN_UNCOMPRESSED_SIZE 64
+
+/*
+	opaque type of bls::PreparedPublicKey
+*/
+typedef struct blsPreparedPublicKey blsPreparedPublicKey;
+
 void blsInit(void);
+/*
+	set the random generator (bls::setRandFunc)
+	readFunc(self, buf, bufSize) fills buf[0, bufSize) with random bytes and returns bufSize
+	blsSetRandFunc(NULL, NULL) restores the default ; ChaCha20 of each thread
+*/
+void blsSetRandFunc(void *self, size_t (*readFunc)(void *self, void *buf, size_t bufSize));
 
 blsId *blsIdCreate(void);
 void blsIdDestroy(blsId *id);
@@ -45,6 +70,14 @@ int blsIdSetStr(blsId *id, const char *buf, size_t bufSize);
 	otherwise 0
 */
 size_t blsIdGetStr(const blsId *id, char *buf, size_t maxBufSize);
+/*
+	blsXSerialize and blsXDeserialize do not allocate memory
+	return written size (BLS_X_SERIALIZED_SIZE)
+	otherwise 0 if maxBufSize is small
+*/
+size_t blsIdSerialize(const blsId *id, uint8_t *buf, size_t maxBufSize);
+// return 0 if success
+int blsIdDeserialize(blsId *id, const uint8_t *buf, size_t bufSize);
 /*
 	access p[0], p[1], p[2], p[3]
 */
@@ -57,6 +90,8 @@ void blsSecretKeyCopy(blsSecretKey *dst, const blsSecretKey *src);
 void blsSecretKeySetArray(blsSecretKey *sec, const uint64_t *p);
 int blsSecretKeySetStr(blsSecretKey *sec, const char *buf, size_t bufSize);
 size_t blsSecretKeyGetStr(const blsSecretKey *sec, char *buf, size_t maxBufSize);
+size_t blsSecretKeySerialize(const blsSecretKey *sec, uint8_t *buf, size_t maxBufSize);
+int blsSecretKeyDeserialize(blsSecretKey *sec, const uint8_t *buf, size_t bufSize);
 void blsSecretKeyAdd(blsSecretKey *sec, const blsSecretKey *rhs);
 
 void blsSecretKeyInit(blsSecretKey *sec);
@@ -72,23 +107,103 @@ void blsPublicKeyPut(const blsPublicKey *pub);
 void blsPublicKeyCopy(blsPublicKey *dst, const blsPublicKey *src);
 int blsPublicKeySetStr(blsPublicKey *pub, const char *buf, size_t bufSize);
 size_t blsPublicKeyGetStr(const blsPublicKey *pub, char *buf, size_t maxBufSize);
+size_t blsPublicKeySerialize(const blsPublicKey *pub, uint8_t *buf, size_t maxBufSize);
+size_t blsPublicKeySerializeUncompressed(const blsPublicKey *pub, uint8_t *buf, size_t maxBufSize);
+int blsPublicKeyDeserialize(blsPublicKey *pub, const uint8_t *buf, size_t bufSize);
 void blsPublicKeyAdd(blsPublicKey *pub, const blsPublicKey *rhs);
+/*
+	pub = pubVec[0] + ... + pubVec[n - 1]
+	return 0 if success
+	return -1 if error such as out of memory
+*/
+int blsPublicKeyAggregate(blsPublicKey *pub, const blsPublicKey *pubVec, size_t n);
 void blsPublicKeySet(blsPublicKey *pub, const blsPublicKey *mpk, size_t k, const blsId *id);
 void blsPublicKeyRecover(blsPublicKey *pub, const blsPublicKey *pubVec, const blsId *idVec, size_t n);
 
+/*
+	precompute the Miller loop coefficients of pub
+	return NULL if error
+*/
+blsPreparedPublicKey *blsPreparedPublicKeyCreate(const blsPublicKey *pub);
+void blsPreparedPublicKeyDestroy(blsPreparedPublicKey *ppub);
+
 blsSign *blsSignCreate(void);
 void blsSignDestroy(blsSign *sign);
 void blsSignPut(const blsSign *sign);
 void blsSignCopy(blsSign *dst, const blsSign *src);
 int blsSignSetStr(blsSign *sign, const char *buf, size_t bufSize);
 size_t blsSignGetStr(const blsSign *sign, char *buf, size_t maxBufSize);
+size_t blsSignSerialize(const blsSign *sign, uint8_t *buf, size_t maxBufSize);
+size_t blsSignSerializeUncompressed(const blsSign *sign, uint8_t *buf, size_t maxBufSize);
+int blsSignDeserialize(blsSign *sign, const uint8_t *buf, size_t bufSize);
 void blsSignAdd(blsSign *sign, const blsSign *rhs);
+/*
+	sign = signVec[0] + ... + signVec[n - 1]
+	return 0 if success
+	return -1 if error such as out of memory
+*/
+int blsSignAggregate(blsSign *sign, const blsSign *signVec, size_t n);
 void blsSignRecover(blsSign *sign, const blsSign *signVec, const blsId *idVec, size_t n);
+/*
+	sign = H(m) where the size of m is size
+*/
+void blsHashToSign(blsSign *sign, const char *m, size_t size);
 
 int blsSignVerify(const blsSign *sign, const blsPublicKey *pub, const char *m, size_t size);
 
 int blsSignVerifyPop(const blsSign *sign, const blsPublicKey *pub);
 
+/*
+	verify sign aggregated from n signs made by pubVec[i] for mVec[i]
+	where the size of mVec[i] is mSizeVec[i]
+	return 1 if valid
+	return 0 if invalid or mVec has the same message
+	return -1 if error such as out of memory
+*/
+int blsSignVerifyAggregate(const blsSign *sign, const blsPublicKey *pubVec, const char *const *mVec, const size_t *mSizeVec, size_t n);
+
+/*
+	return 1 if valid, 0 if invalid
+	return -1 if error such as ppub is not set
+*/
+int blsSignVerifyPrepared(const blsSign *sign, const blsPreparedPublicKey *ppub, const char *m, size_t size);
+
+/*
+	verify n triples (signVec[i], pubVec[i], mVec[i]) at once
+	where the size of mVec[i] is mSizeVec[i]
+	return 1 if all of them are valid
+	if resultVec is not NULL then resultVec[i] is set to 1 if the i-th triple is valid
+	otherwise 0
+	return -1 if error such as out of memory (resultVec is not set)
+*/
+int blsSignVerifyBatch(const blsSign *signVec, const blsPublicKey *pubVec, const char *const *mVec, const size_t *mSizeVec, size_t n, int *resultVec);
+
+/*
+	counters of the hot paths (bls::StatsCounter)
+	they are zero unless the library is built with -DBLS_ENABLE_STATS
+	histogram[i] is the number of calls which take [2^i, 2^(i+1)) nsec
+*/
+#define BLS_STATS_HISTOGRAM_SIZE 32
+
+typedef struct {
+	uint64_t count;
+	uint64_t totalNsec;
+	uint64_t histogram[BLS_STATS_HISTOGRAM_SIZE];
+} blsStatsCounter;
+
+// return 1 if the library is built with -DBLS_ENABLE_STATS
+int blsStatsIsEnabled(void);
+// return the number of the operations
+size_t blsStatsGetOpNum(void);
+// return the name of the op-th operation or NULL if op >= blsStatsGetOpNum()
+const char *blsStatsGetOpName(size_t op);
+/*
+	counterVec[i] = the counter of the i-th operation for i < min(maxN, blsStatsGetOpNum())
+	return the number of written counters
+*/
+size_t blsStatsGet(blsStatsCounter *counterVec, size_t maxN);
+void blsStatsReset(void);
+
 #ifdef __cplusplus
 }
 #endif
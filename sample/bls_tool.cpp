@@ -1,5 +1,6 @@
 #include <bls.hpp>
 #include <iostream>
+#include <fstream>
 #include <cybozu/option.hpp>
 
 template<class T>
@@ -37,6 +38,24 @@ void readMessage(std::string& str)
 }
 
 bool g_verbose = false;
+std::string g_file;
+
+/*
+	read g_file chunk by chunk into h
+*/
+void hashFile(bls::MessageHasher& h)
+{
+	std::ifstream ifs(g_file.c_str(), std::ios::binary);
+	if (!ifs) throw std::runtime_error("hashFile:can't open " + g_file);
+	char buf[1024 * 64];
+	for (;;) {
+		ifs.read(buf, sizeof(buf));
+		const size_t readSize = (size_t)ifs.gcount();
+		if (readSize == 0) break;
+		h.update(buf, readSize);
+	}
+	if (ifs.bad()) throw std::runtime_error("hashFile:can't read " + g_file);
+}
 
 void init()
 {
@@ -64,11 +83,18 @@ void sign()
 	bls::SecretKey sec;
 	read(sec);
 	if (g_verbose) std::cerr << "sec:" << sec << std::endl;
-	std::string m;
-	readMessage(m);
-	if (g_verbose) fprintf(stderr, "message:`%s`\n", m.c_str());
 	bls::Sign s;
-	sec.sign(s, m);
+	if (g_file.empty()) {
+		std::string m;
+		readMessage(m);
+		if (g_verbose) fprintf(stderr, "message:`%s`\n", m.c_str());
+		sec.sign(s, m);
+	} else {
+		if (g_verbose) fprintf(stderr, "file:`%s`\n", g_file.c_str());
+		bls::MessageHasher h;
+		hashFile(h);
+		sec.sign(s, h);
+	}
 	write(s);
 }
 
@@ -81,10 +107,18 @@ void verify()
 	bls::PublicKey pub;
 	read(pub);
 	if (g_verbose) std::cerr << "pub:" << pub << std::endl;
-	std::string m;
-	readMessage(m);
-	if (g_verbose) fprintf(stderr, "message:`%s`\n", m.c_str());
-	bool b = s.verify(pub, m);
+	bool b;
+	if (g_file.empty()) {
+		std::string m;
+		readMessage(m);
+		if (g_verbose) fprintf(stderr, "message:`%s`\n", m.c_str());
+		b = s.verify(pub, m);
+	} else {
+		if (g_verbose) fprintf(stderr, "file:`%s`\n", g_file.c_str());
+		bls::MessageHasher h;
+		hashFile(h);
+		b = s.verify(pub, h);
+	}
 	write(b ? "1" : "0");
 }
 
@@ -130,14 +164,16 @@ void aggregate_pub()
 	read(n);
 	if (n == 0) throw std::runtime_error("aggregate_pub:n is zero");
 	if (g_verbose) fprintf(stderr, "n:%d\n", (int)n);
-	bls::PublicKey pub;
-	read(pub);
-	if (g_verbose) std::cerr << "pub:" << pub << std::endl;
-	for (size_t i = 1; i < n; i++) {
+	// n is not trusted ; a vector grows only by the items actually read
+	bls::PublicKeyVec pubVec;
+	for (size_t i = 0; i < n; i++) {
 		bls::PublicKey rhs;
 		read(rhs);
-		pub.add(rhs);
+		pubVec.push_back(rhs);
 	}
+	if (g_verbose) std::cerr << "pub:" << pubVec[0] << std::endl;
+	bls::PublicKey pub;
+	pub.aggregate(pubVec);
 	write(pub);
 }
 
@@ -148,14 +184,16 @@ void aggregate_sig()
 	read(n);
 	if (n == 0) throw std::runtime_error("aggregate_sig:n is zero");
 	if (g_verbose) fprintf(stderr, "n:%d\n", (int)n);
-	bls::Sign s;
-	read(s);
-	if (g_verbose) std::cerr << "sign:" << s << std::endl;
-	for (size_t i = 1; i < n; i++) {
+	// n is not trusted ; a vector grows only by the items actually read
+	bls::SignVec sVec;
+	for (size_t i = 0; i < n; i++) {
 		bls::Sign rhs;
 		read(rhs);
-		s.add(rhs);
+		sVec.push_back(rhs);
 	}
+	if (g_verbose) std::cerr << "sign:" << sVec[0] << std::endl;
+	bls::Sign s;
+	s.aggregate(sVec);
 	write(s);
 }
 
@@ -185,6 +223,7 @@ int main(int argc, char *argv[])
 	
 	opt.appendParam(&mode, cmdCat.c_str());
 	opt.appendBoolOpt(&g_verbose, "v", ": verbose");
+	opt.appendOpt(&g_file, "", "f", ": read the message of sign/verify from the file");
 	opt.appendHelp("h");
 	if (!opt.parse(argc, argv)) {
 		goto ERR_EXIT;
@@ -5,296 +5,2125 @@
 	http://opensource.org/licenses/BSD-3-Clause
 */
 #include <bls.hpp>
+#include "bls_qtbl.hpp"
+#include "lru_cache.hpp"
+#include "bls_glv.hpp"
+#include "bls_rand.hpp"
+#include "stats.hpp"
+#include "thread_pool.hpp"
 #include <mcl/bn256.hpp>
 #include <cybozu/crypto.hpp>
-#include <cybozu/random_generator.hpp>
 #include <vector>
 #include <string>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
 
 using namespace mcl::bn256;
 typedef std::vector<Fr> FrVec;
 
 #define PUT(x) std::cout << #x << "=" << x << std::endl;
 
-static cybozu::RandomGenerator& getRG()
+namespace bls {
+
+static void *randSelf = 0;
+static ReadRandFunc readRandFunc = 0;
+
+/*
+	buf[0, n) = random bytes by the function of setRandFunc
+	or by ChaCha20 of each thread which needs no lock
+*/
+static void readRand(void *buf, size_t n)
+{
+	if (readRandFunc) {
+		if (readRandFunc(randSelf, buf, n) != n) throw cybozu::Exception("bls:readRand:readFunc failed") << n;
+		return;
+	}
+	if (!rand::readRand(buf, n)) throw cybozu::Exception("bls:readRand:getEntropy failed") << n;
+}
+
+/*
+	the interface of Fr::setRand
+*/
+struct RandGenerator {
+	template<class T>
+	void read(T *out, size_t n)
+	{
+		readRand(out, n * sizeof(T));
+	}
+};
+
+static void setRandom(Fr& x)
+{
+	RandGenerator rg;
+	x.setRand(rg);
+}
+
+void setRandFunc(void *self, ReadRandFunc readFunc)
+{
+	randSelf = self;
+	readRandFunc = readFunc;
+}
+
+/*
+	precomputeG2(Q)
+*/
+static const std::vector<Fp6>& getQcoeff()
+{
+	static const std::vector<Fp6> Qcoeff(
+		reinterpret_cast<const Fp6*>(qtbl::Qcoeff),
+		reinterpret_cast<const Fp6*>(qtbl::Qcoeff) + qtbl::QcoeffN);
+	return Qcoeff;
+}
+
+/*
+	y[0, keySize) = x for x in Fr or Fp
+*/
+template<class F>
+void getScalarArray(uint64_t *y, const F& x)
+{
+	mcl::fp::Block b;
+	x.getBlock(b);
+	for (size_t i = 0; i < keySize; i++) {
+		y[i] = i < b.n ? b.p[i] : 0;
+	}
+}
+
+/*
+	return v[pos, pos + c) where v is a little endian array of keySize uint64_t
+*/
+static size_t getBits(const uint64_t *v, size_t pos, size_t c)
+{
+	const size_t q = pos / 64;
+	const size_t r = pos % 64;
+	uint64_t x = v[q] >> r;
+	if (r + c > 64 && q + 1 < keySize) x |= v[q + 1] << (64 - r);
+	return size_t(x & ((uint64_t(1) << c) - 1));
+}
+
+static glv::GLV1& getGLV1()
+{
+	static glv::GLV1 glv1;
+	return glv1;
+}
+
+static glv::GLS2& getGLS2()
+{
+	static glv::GLS2 gls2;
+	return gls2;
+}
+
+/*
+	z = x y by GLV
+*/
+static void mulG1(G1& z, const G1& x, const Fr& y)
+{
+	BLS_STATS_SCOPE(StatsG1Mul);
+	getGLV1().mul(z, x, y);
+}
+
+/*
+	z = x y by GLS
+	a small y such as an id is done by G2::mul
+	because the table of GLS does not pay for it
+*/
+static void mulG2(G2& z, const G2& x, const Fr& y)
+{
+	BLS_STATS_SCOPE(StatsG2Mul);
+	uint64_t v[keySize];
+	getScalarArray(v, y);
+	if (v[2] == 0 && v[3] == 0) {
+		G2::mul(z, x, y);
+		return;
+	}
+	getGLS2().mul(z, x, y);
+}
+
+static void mulG(Fr& z, const Fr& x, const Fr& y) { Fr::mul(z, x, y); }
+static void mulG(G1& z, const G1& x, const Fr& y) { mulG1(z, x, y); }
+static void mulG(G2& z, const G2& x, const Fr& y) { mulG2(z, x, y); }
+
+static void mapToG1(G1& P, const Fp& t)
+{
+	BLS_STATS_SCOPE(StatsMapToG1);
+	static mcl::bn::MapTo<Fp> mapTo;
+	mapTo.calcG1(P, t);
+}
+
+/*
+	H(m) keyed by SHA-256(m)
+	hashCacheEnabled avoids locking the cache if it is disabled
+*/
+static LruCache<std::string, G1>& getHashCache()
+{
+	static LruCache<std::string, G1> cache;
+	return cache;
+}
+
+static std::atomic<bool> hashCacheEnabled(false);
+
+/*
+	P = H(m) for digest = SHA-256(m)
+*/
+static void mapDigestToG1(G1& P, const std::string& digest)
+{
+	const bool useCache = hashCacheEnabled.load(std::memory_order_relaxed);
+	if (useCache && getHashCache().get(P, digest)) return;
+	Fp t;
+	t.setArrayMask(digest.c_str(), digest.size());
+	mapToG1(P, t);
+	if (useCache) getHashCache().put(digest, P);
+}
+
+static void HashAndMapToG1(G1& P, const void *m, size_t mSize)
+{
+	BLS_STATS_SCOPE(StatsHashToG1);
+	cybozu::crypto::Hash h(cybozu::crypto::Hash::N_SHA256);
+	mapDigestToG1(P, h.digest(m, mSize));
+}
+
+static void HashAndMapToG1(G1& P, const std::string& m)
+{
+	HashAndMapToG1(P, m.data(), m.size());
+}
+
+template<class T, class G, class Vec>
+void evalPoly(G& y, const T& x, const Vec& c)
+{
+	if (c.size() < 2) throw cybozu::Exception("bls:evalPoly:bad size") << c.size();
+	y = c[c.size() - 1];
+	for (int i = (int)c.size() - 2; i >= 0; i--) {
+		mulG(y, y, x);
+		G::add(y, y, c[i]);
+	}
+}
+
+/*
+	P = (x z^-2, y z^-3, 1) for Jacobian P = (x, y, z) and zInv = 1/z
+*/
+template<class G, class F>
+void setAffine(G& P, const F& zInv)
+{
+	F t;
+	F::sqr(t, zInv);
+	F::mul(P.x, P.x, t);
+	F::mul(t, t, zInv);
+	F::mul(P.y, P.y, t);
+	F::mul(P.z, P.z, zInv); // 1
+}
+
+/*
+	normalize v[0, n) with one inversion (Montgomery's trick)
+	then the addition with v[i] is a mixed addition
+*/
+template<class G>
+void normalizeVec(G *v, size_t n)
+{
+	typedef decltype(v->z) F;
+	std::vector<size_t> idx;
+	idx.reserve(n);
+	for (size_t i = 0; i < n; i++) {
+		if (!v[i].isZero() && !v[i].z.isOne()) idx.push_back(i);
+	}
+	const size_t m = idx.size();
+	if (m == 0) return;
+	BLS_STATS_SCOPE(StatsNormalize);
+	// t[i] = prod_{j <= i} z_idx[j]
+	std::vector<F> t(m);
+	t[0] = v[idx[0]].z;
+	for (size_t i = 1; i < m; i++) {
+		F::mul(t[i], t[i - 1], v[idx[i]].z);
+	}
+	F inv, zInv;
+	F::inv(inv, t[m - 1]);
+	for (size_t i = m - 1; i > 0; i--) {
+		G& P = v[idx[i]];
+		F::mul(zInv, inv, t[i - 1]);
+		F::mul(inv, inv, P.z);
+		setAffine(P, zInv);
+	}
+	setAffine(v[idx[0]], inv);
+}
+
+/*
+	r = sum_i v[i]
+	v is normalized in place and added by mixed additions
+*/
+template<class G>
+void sumMixed(G& r, G *v, size_t n)
+{
+	normalizeVec(v, n);
+	r.clear();
+	for (size_t i = 0; i < n; i++) {
+		r += v[i];
+	}
+}
+
+/*
+	a = P where P is normalized
+	P = a for the affine point a
+*/
+template<class A, class G>
+void getAffinePoint(A& a, const G& P)
+{
+	if (P.isZero()) {
+		a.x.clear();
+		a.y.clear();
+		return;
+	}
+	a.x = P.x;
+	a.y = P.y;
+}
+
+template<class G, class A>
+void setAffinePoint(G& P, const A& a)
+{
+	if (a.x.isZero() && a.y.isZero()) {
+		P.clear();
+		return;
+	}
+	P.x = a.x;
+	P.y = a.y;
+	P.z = 1;
+}
+
+/*
+	r = sum_i v[i] by mixed additions for the affine points v
+*/
+template<class G, class A>
+void sumAffine(G& r, const A *v, size_t n)
+{
+	r.clear();
+	G P;
+	for (size_t i = 0; i < n; i++) {
+		setAffinePoint(P, v[i]);
+		r += P;
+	}
+}
+
+/*
+	r = sum_i vec[i] for i in [0, n)
+	vec is copied and normalized block by block with one inversion per block
+	and added by mixed additions, then the sums of the blocks are added by a pairwise tree
+	the blocks are shared by the threads of pool if it is not NULL
+*/
+template<class G, class V>
+void aggregateG(G& r, const V& vec, size_t n, ThreadPool *pool)
+{
+	const size_t blockSize = 1024;
+	const size_t blockN = (n + blockSize - 1) / blockSize;
+	if (blockN == 0) {
+		r.clear();
+		return;
+	}
+	std::vector<G> partial(blockN);
+	parallelFor(pool, blockN, [&](size_t begin, size_t end) {
+		std::vector<G> v(blockSize);
+		for (size_t b = begin; b < end; b++) {
+			const size_t top = b * blockSize;
+			const size_t m = std::min(blockSize, n - top);
+			for (size_t i = 0; i < m; i++) {
+				v[i] = vec[top + i];
+			}
+			sumMixed(partial[b], v.data(), m);
+		}
+	}, 1);
+	for (size_t d = 1; d < blockN; d *= 2) {
+		for (size_t i = 0; i + d < blockN; i += d * 2) {
+			partial[i] += partial[i + d];
+		}
+	}
+	r = partial[0];
+}
+
+/*
+	r = sum_i v[i] by mixed additions
+	each thread of pool sums a part of v
+*/
+template<class G, class A>
+void sumAffine(G& r, const A *v, size_t n, ThreadPool *pool)
+{
+	if (pool == 0 || pool->getThreadNum() == 1 || n <= 1) {
+		sumAffine(r, v, n);
+		return;
+	}
+	const size_t threadNum = pool->getThreadNum();
+	const size_t grainSize = (n + threadNum - 1) / threadNum;
+	std::vector<G> partial((n + grainSize - 1) / grainSize);
+	pool->run(n, [&](size_t begin, size_t end) {
+		sumAffine(partial[begin / grainSize], v + begin, end - begin);
+	}, grainSize);
+	r.clear();
+	for (size_t i = 0; i < partial.size(); i++) {
+		r += partial[i];
+	}
+}
+
+/*
+	fixed-base table of Q with w-bit windows
+	tbl[i * (2^w - 1) + j - 1] = j 2^(w i) Q for 0 <= i < windowNum, 1 <= j < 2^w
+	qtbl::mulTbl generated at build time is used for w = qtbl::windowBit
+*/
+struct MulQTable {
+	size_t w;
+	size_t windowNum;
+	std::vector<G2> buf;
+	const G2 *tbl;
+	MulQTable()
+		: w(qtbl::windowBit)
+		, windowNum(qtbl::windowNum)
+		, tbl(reinterpret_cast<const G2*>(qtbl::mulTbl))
+	{
+	}
+	void set(size_t w)
+	{
+		if (w == 0 || w > maxPublicKeyTableWindow) throw cybozu::Exception("bls:setPublicKeyTableWindow:bad w") << w;
+		const size_t windowNum = (256 + w - 1) / w;
+		std::vector<G2> buf;
+		if (w != qtbl::windowBit) {
+			const size_t m = (size_t(1) << w) - 1;
+			buf.resize(windowNum * m);
+			G2 base = *reinterpret_cast<const G2*>(qtbl::Q);
+			for (size_t i = 0; i < windowNum; i++) {
+				G2 *t = &buf[i * m];
+				t[0] = base;
+				for (size_t j = 1; j < m; j++) {
+					G2::add(t[j], t[j - 1], base);
+				}
+				for (size_t j = 0; j < w; j++) {
+					G2::dbl(base, base);
+				}
+			}
+			normalizeVec(buf.data(), buf.size());
+		}
+		this->w = w;
+		this->windowNum = windowNum;
+		this->buf.swap(buf);
+		tbl = this->buf.empty() ? reinterpret_cast<const G2*>(qtbl::mulTbl) : this->buf.data();
+	}
+	size_t getMemorySize() const
+	{
+		return windowNum * ((size_t(1) << w) - 1) * sizeof(G2);
+	}
+};
+
+static MulQTable& getMulQTable()
+{
+	static MulQTable t;
+	return t;
+}
+
+/*
+	z = x Q by getMulQTable()
+	windowNum mixed additions and no doubling
+*/
+static void mulQ(G2& z, const Fr& x)
+{
+	BLS_STATS_SCOPE(StatsG2Mul);
+	const MulQTable& t = getMulQTable();
+	const size_t w = t.w;
+	const size_t m = (size_t(1) << w) - 1;
+	uint64_t v[keySize];
+	getScalarArray(v, x);
+	z.clear();
+	for (size_t i = 0; i < t.windowNum; i++) {
+		const size_t d = getBits(v, i * w, w);
+		if (d) z += t.tbl[i * m + d - 1];
+	}
+}
+
+template<class T, class G>
+struct WrapArray {
+	const T *v;
+	size_t k;
+	WrapArray(const T *v, size_t k) : v(v), k(k) {}
+	const G& operator[](size_t i) const
+	{
+		return v[i].getInner().get();
+	}
+	size_t size() const { return k; }
+	static G& get(T& t) { return t.getInner().get(); }
+};
+
+/*
+	writable version of WrapArray
+*/
+template<class T, class G>
+struct WrapOutArray {
+	T *v;
+	explicit WrapOutArray(T *v) : v(v) {}
+	G& operator[](size_t i) const
+	{
+		return WrapArray<T, G>::get(v[i]);
+	}
+};
+
+/*
+	window bit size of mulVecG for n points
+	about log2(n) - 2 balances n additions per window and 2^c additions of the buckets
+*/
+static size_t getMsmWindowBit(size_t n)
+{
+	size_t c = 0;
+	while ((size_t(1) << c) < n) c++;
+	if (c <= 4) return 2;
+	return std::min<size_t>(c - 2, 16);
+}
+
+/*
+	return the bit length of v[0, keySize)
+*/
+static size_t getBitLen(const uint64_t *v)
+{
+	for (size_t j = keySize; j > 0; j--) {
+		if (v[j - 1] == 0) continue;
+		size_t bit = (j - 1) * 64;
+		for (uint64_t x = v[j - 1]; x; x >>= 1) bit++;
+		return bit;
+	}
+	return 0;
+}
+
+/*
+	r = sum_i sv[i] P[i] by Pippenger's bucket method
+	sv[i] is sv[i * keySize, (i + 1) * keySize) less than 2^maxBit
+	for each c-bit window, P[i] is added to the bucket of its digit
+	and the buckets are summed up as sum_j j bucket[j] by 2^(c+1) additions
+*/
+template<class G>
+void mulVecBucket(G& r, std::vector<G>& P, const std::vector<uint64_t>& sv, size_t maxBit)
+{
+	r.clear();
+	const size_t n = P.size();
+	if (maxBit == 0) return;
+	normalizeVec(P.data(), n); // for mixed additions to the buckets
+	const size_t c = getMsmWindowBit(n);
+	const size_t winNum = (maxBit + c - 1) / c;
+	std::vector<G> bucket((size_t(1) << c) - 1);
+	G sum, t;
+	for (size_t w = winNum; w > 0; w--) {
+		for (size_t i = 0; i < c; i++) {
+			G::dbl(r, r);
+		}
+		for (size_t j = 0; j < bucket.size(); j++) {
+			bucket[j].clear();
+		}
+		const size_t pos = (w - 1) * c;
+		for (size_t i = 0; i < n; i++) {
+			const size_t d = getBits(&sv[i * keySize], pos, c);
+			if (d) bucket[d - 1] += P[i];
+		}
+		// t = sum_j (j + 1) bucket[j]
+		sum.clear();
+		t.clear();
+		for (size_t j = bucket.size(); j > 0; j--) {
+			sum += bucket[j - 1];
+			t += sum;
+		}
+		r += t;
+	}
+}
+
+/*
+	r = sum_i s[i] vec[i]
+	vec[i] and s[i] are G and Fr
+*/
+template<class G, class V, class S>
+void mulVecG(G& r, const V& vec, const S& s, size_t n)
+{
+	std::vector<G> P(n);
+	std::vector<uint64_t> sv(n * keySize);
+	size_t maxBit = 0;
+	for (size_t i = 0; i < n; i++) {
+		P[i] = vec[i];
+		uint64_t *v = &sv[i * keySize];
+		getScalarArray(v, s[i]);
+		maxBit = std::max(maxBit, getBitLen(v));
+	}
+	mulVecBucket(r, P, sv, maxBit);
+}
+
+/*
+	r = sum_i s[i] vec[i] for G1
+	s[i] vec[i] = k0 vec[i] + k1 phi(vec[i]) by GLV halves the number of windows
+*/
+template<class V, class S>
+void mulVecG(G1& r, const V& vec, const S& s, size_t n)
+{
+	BLS_STATS_SCOPE(StatsMulVec);
+	const glv::GLV1& glv1 = getGLV1();
+	std::vector<G1> P(n * 2);
+	std::vector<uint64_t> sv(n * 2 * keySize);
+	size_t maxBit = 0;
+	mpz_class k[2];
+	for (size_t i = 0; i < n; i++) {
+		glv1.split(k[0], k[1], s[i]);
+		P[i * 2] = vec[i];
+		glv1.mulLambda(P[i * 2 + 1], vec[i]);
+		for (size_t j = 0; j < 2; j++) {
+			G1& Q = P[i * 2 + j];
+			if (k[j] < 0) {
+				k[j] = -k[j];
+				G1::neg(Q, Q);
+			}
+			uint64_t *v = &sv[(i * 2 + j) * keySize];
+			glv::getArray(v, keySize, k[j]);
+			maxBit = std::max(maxBit, getBitLen(v));
+		}
+	}
+	mulVecBucket(r, P, sv, maxBit);
+}
+
+/*
+	r = sum_i s[i] vec[i] for G2
+	s[i] vec[i] = sum_{j < 4} k[j] psi^j(vec[i]) by GLS quarters the number of windows
+*/
+template<class V, class S>
+void mulVecG(G2& r, const V& vec, const S& s, size_t n)
+{
+	BLS_STATS_SCOPE(StatsMulVec);
+	const glv::GLS2& gls2 = getGLS2();
+	std::vector<G2> P(n * 4);
+	std::vector<uint64_t> sv(n * 4 * keySize);
+	size_t maxBit = 0;
+	mpz_class k[4];
+	for (size_t i = 0; i < n; i++) {
+		gls2.split(k, s[i]);
+		P[i * 4] = vec[i];
+		for (size_t j = 1; j < 4; j++) {
+			gls2.psi(P[i * 4 + j], P[i * 4 + j - 1]);
+		}
+		for (size_t j = 0; j < 4; j++) {
+			G2& Q = P[i * 4 + j];
+			if (k[j] < 0) {
+				k[j] = -k[j];
+				G2::neg(Q, Q);
+			}
+			uint64_t *v = &sv[(i * 4 + j) * keySize];
+			glv::getArray(v, keySize, k[j]);
+			maxBit = std::max(maxBit, getBitLen(v));
+		}
+	}
+	mulVecBucket(r, P, sv, maxBit);
+}
+
+/*
+	r = sum_i s[i] vec[i] for Fr
+*/
+template<class V, class S>
+void mulVecG(Fr& r, const V& vec, const S& s, size_t n)
+{
+	r.clear();
+	for (size_t i = 0; i < n; i++) {
+		r += vec[i] * s[i];
+	}
+}
+
+struct Polynomial {
+	FrVec c; // f[x] = sum_{i=0}^{k-1} c[i] x^i
+	void init(const Fr& s, int k)
+	{
+		if (k < 2) throw cybozu::Exception("bls:Polynomial:init:bad k") << k;
+		c.resize(k);
+		c[0] = s;
+		for (size_t i = 1; i < c.size(); i++) {
+			setRandom(c[i]);
+		}
+	}
+	// y = f(id)
+	void eval(Fr& y, const Fr& id) const
+	{
+		if (id.isZero()) throw cybozu::Exception("bls:Polynomial:eval:id is zero");
+		evalPoly(y, id, c);
+	}
+};
+
+/*
+	check prod_i e(Q_i, P_i) = 1
+	the Miller loops of all pairs are multiplied and
+	the final exponentiation is done only once
+*/
+class PairingCheck {
+	std::vector<G2> Qvec_;
+	std::vector<G1> Pvec_;
+	std::vector<const std::vector<Fp6>*> QcoeffVec_;
+	std::vector<G1> PcoeffVec_;
+public:
+	void reserve(size_t n)
+	{
+		Qvec_.reserve(n);
+		Pvec_.reserve(n);
+	}
+	void add(const G2& Q, const G1& P)
+	{
+		Qvec_.push_back(Q);
+		Pvec_.push_back(P);
+	}
+	/*
+		Qcoeff = precomputeG2(Q)
+		@note Qcoeff must be alive until check()
+	*/
+	void add(const std::vector<Fp6>& Qcoeff, const G1& P)
+	{
+		QcoeffVec_.push_back(&Qcoeff);
+		PcoeffVec_.push_back(P);
+	}
+	size_t size() const { return Qvec_.size() + QcoeffVec_.size(); }
+	void clear()
+	{
+		Qvec_.clear();
+		Pvec_.clear();
+		QcoeffVec_.clear();
+		PcoeffVec_.clear();
+	}
+	/*
+		f = millerLoop of the i-th pair
+		the pairs added by add(Qcoeff, P) follow the ones by add(Q, P)
+	*/
+	void millerLoop1(Fp12& f, size_t i) const
+	{
+		BLS_STATS_SCOPE(StatsMillerLoop);
+		if (i < Qvec_.size()) {
+			BN::millerLoop(f, Qvec_[i], Pvec_[i]);
+		} else {
+			i -= Qvec_.size();
+			BN::precomputedMillerLoop(f, PcoeffVec_[i], *QcoeffVec_[i]);
+		}
+	}
+	/*
+		f = prod_{begin <= i < end} millerLoop(Q_i, P_i)
+	*/
+	void millerLoop(Fp12& f, size_t begin, size_t end) const
+	{
+		millerLoop1(f, begin);
+		Fp12 e;
+		for (size_t i = begin + 1; i < end; i++) {
+			millerLoop1(e, i);
+			Fp12::mul(f, f, e);
+		}
+	}
+	/*
+		f = prod_i millerLoop(Q_i, P_i)
+		each thread of pool computes the product of a part of the pairs if pool is not NULL
+	*/
+	void millerLoop(Fp12& f, ThreadPool *pool = 0) const
+	{
+		const size_t n = size();
+		if (n == 0) throw cybozu::Exception("bls:PairingCheck:empty");
+		if (pool == 0 || pool->getThreadNum() == 1 || n == 1) {
+			millerLoop(f, 0, n);
+			return;
+		}
+		const size_t threadNum = pool->getThreadNum();
+		const size_t grainSize = (n + threadNum - 1) / threadNum;
+		std::vector<Fp12> partial((n + grainSize - 1) / grainSize);
+		pool->run(n, [&](size_t begin, size_t end) {
+			millerLoop(partial[begin / grainSize], begin, end);
+		}, grainSize);
+		f = partial[0];
+		for (size_t i = 1; i < partial.size(); i++) {
+			Fp12::mul(f, f, partial[i]);
+		}
+	}
+	/*
+		return true if finalExp(f) = 1
+	*/
+	static bool isOne(const Fp12& f)
+	{
+		BLS_STATS_SCOPE(StatsFinalExp);
+		Fp12 e;
+		BN::finalExp(e, f);
+		return e.isOne();
+	}
+	bool check(ThreadPool *pool = 0) const
+	{
+		Fp12 f;
+		millerLoop(f, pool);
+		return isOne(f);
+	}
+};
+
+/*
+	inv[i] = 1 / v[i] by one inversion
+*/
+static void invVec(FrVec& inv, const FrVec& v)
+{
+	BLS_STATS_SCOPE(StatsLagrangeInv);
+	const size_t n = v.size();
+	inv.resize(n);
+	if (n == 0) return;
+	// inv[i] = prod_{j <= i} v[j] temporarily
+	inv[0] = v[0];
+	for (size_t i = 1; i < n; i++) {
+		inv[i] = inv[i - 1] * v[i];
+	}
+	Fr t;
+	Fr::inv(t, inv[n - 1]);
+	for (size_t i = n - 1; i > 0; i--) {
+		inv[i] = t * inv[i - 1];
+		t *= v[i];
+	}
+	inv[0] = t;
+}
+
+namespace impl {
+
+struct Id {
+	Fr v;
+	const Fr& get() const { return v; }
+};
+
+struct SecretKey {
+	Fr s;
+	const Fr& get() const { return s; }
+	Fr& get() { return s; }
+};
+
+struct Sign {
+	G1 sHm; // s Hash(m)
+	const G1& get() const { return sHm; }
+	G1& get() { return sHm; }
+};
+
+struct PublicKey {
+	G2 sQ;
+	const G2& get() const { return sQ; }
+	G2& get() { return sQ; }
+	void getStr(std::string& str) const
+	{
+		sQ.getStr(str, mcl::IoArrayRaw);
+	}
+};
+
+/*
+	(0, 0) is the point at infinity
+*/
+template<class F>
+struct AffinePoint {
+	F x, y;
+	bool operator==(const AffinePoint& rhs) const { return x == rhs.x && y == rhs.y; }
+};
+
+struct AffineSign : AffinePoint<Fp> {
+	AffineSign& get() { return *this; }
+	const AffineSign& get() const { return *this; }
+};
+
+struct AffinePublicKey : AffinePoint<Fp2> {
+	AffinePublicKey& get() { return *this; }
+	const AffinePublicKey& get() const { return *this; }
+};
+
+struct AggregatePublicKeyCache {
+	LruCache<std::string, G2> cache;
+	explicit AggregatePublicKeyCache(size_t maxSize) : cache(maxSize) {}
+	template<class V>
+	static void aggregate(G2& agg, const V& pubVec, bls::ThreadPool *pool = 0)
+	{
+		aggregateG(agg, pubVec, pubVec.size(), pool);
+	}
+	template<class V>
+	bool get(G2& agg, const std::string& key, const V& pubVec)
+	{
+		if (cache.get(agg, key)) return true;
+		aggregate(agg, pubVec);
+		cache.put(key, agg);
+		return false;
+	}
+};
+
+/*
+	tables for the ids 1, ..., n
+	let D_i = prod_{j in S, j != i} (j - i) for a subset S
+	then delta_{i,S}(0) = (prod_{j in S} j) / (i D_i)
+	1/D_i = prod_{j in S, j != i} 1/(j - i) by k - 1 multiplications
+	or 1/D_i = W_i prod_{j not in S} (j - i) by n - k multiplications
+	where W_i = 1/prod_{j != i} (j - i) = (-1)^(i-1) / ((i-1)! (n-i)!)
+*/
+struct LagrangeContext {
+	size_t n;
+	FrVec frTbl; // frTbl[i] = i
+	FrVec invTbl; // invTbl[i] = 1/i
+	FrVec W; // W[i] = W_i
+	explicit LagrangeContext(size_t n)
+		: n(n)
+	{
+		if (n == 0) throw cybozu::Exception("bls:LagrangeContext:n is zero");
+		frTbl.resize(n + 1);
+		for (size_t i = 0; i <= n; i++) {
+			frTbl[i] = (int64_t)i;
+		}
+		FrVec fact(n + 1), invFact;
+		fact[0] = 1;
+		for (size_t i = 1; i <= n; i++) {
+			fact[i] = fact[i - 1] * frTbl[i];
+		}
+		invVec(invFact, fact);
+		invTbl.resize(n + 1);
+		W.resize(n + 1);
+		for (size_t i = 1; i <= n; i++) {
+			invTbl[i] = invFact[i] * fact[i - 1];
+			W[i] = invFact[i - 1] * invFact[n - i];
+			if ((i - 1) & 1) Fr::neg(W[i], W[i]);
+		}
+	}
+	/*
+		return x as an integer in [1, n]
+	*/
+	size_t getIdx(const Fr& x) const
+	{
+		uint64_t v[keySize];
+		getScalarArray(v, x);
+		for (size_t i = 1; i < keySize; i++) {
+			if (v[i]) throw cybozu::Exception("bls:LagrangeContext:too large id") << x;
+		}
+		if (v[0] == 0 || v[0] > n) throw cybozu::Exception("bls:LagrangeContext:bad id") << v[0] << n;
+		return size_t(v[0]);
+	}
+	/*
+		y = (j - i) and return true if it is negative
+	*/
+	bool mulDiff(Fr& y, size_t j, size_t i, const FrVec& tbl) const
+	{
+		if (j > i) {
+			y *= tbl[j - i];
+			return false;
+		}
+		y *= tbl[i - j];
+		return true;
+	}
+	/*
+		delta[i] = delta_{i,S}(0) without inversion
+	*/
+	template<class V>
+	void getCoeff(FrVec& delta, const V& S) const
+	{
+		const size_t k = S.size();
+		std::vector<size_t> idx(k);
+		for (size_t i = 0; i < k; i++) {
+			idx[i] = getIdx(S[i]);
+		}
+		// O(k log k) instead of a table of n flags for each call
+		std::vector<size_t> sorted(idx);
+		std::sort(sorted.begin(), sorted.end());
+		for (size_t i = 1; i < k; i++) {
+			if (sorted[i] == sorted[i - 1]) throw cybozu::Exception("bls:LagrangeContext:S has same id") << sorted[i];
+		}
+		const bool useComplement = n - k < k;
+		std::vector<size_t> comp; // [1, n] - S made from the gaps of sorted
+		if (useComplement) {
+			comp.reserve(n - k);
+			size_t j = 1;
+			for (size_t i = 0; i < k; i++) {
+				for (; j < sorted[i]; j++) comp.push_back(j);
+				j = sorted[i] + 1;
+			}
+			for (; j <= n; j++) comp.push_back(j);
+		}
+		Fr a = frTbl[idx[0]];
+		for (size_t i = 1; i < k; i++) {
+			a *= frTbl[idx[i]];
+		}
+		delta.resize(k);
+		for (size_t i = 0; i < k; i++) {
+			const size_t x = idx[i];
+			Fr& d = delta[i];
+			bool neg = false;
+			if (useComplement) {
+				d = W[x];
+				for (size_t j = 0; j < comp.size(); j++) {
+					neg ^= mulDiff(d, comp[j], x, frTbl);
+				}
+			} else {
+				d = 1;
+				for (size_t j = 0; j < k; j++) {
+					if (j != i) neg ^= mulDiff(d, idx[j], x, invTbl);
+				}
+			}
+			d *= invTbl[x];
+			d *= a;
+			if (neg) Fr::neg(d, d);
+		}
+	}
+};
+
+struct CommitteeAggregator {
+	size_t n;
+	size_t blockSize;
+	std::vector<G2> pubVec; // normalized
+	std::vector<G2> blockSum; // normalized
+	G2 total; // sum of pubVec
+	CommitteeAggregator(const bls::PublicKeyVec& v, size_t blockSize)
+		: n(v.size())
+		, blockSize(blockSize)
+		, pubVec(n)
+		, blockSum(getBlockNum(n, blockSize))
+	{
+		WrapArray<bls::PublicKey, G2> w(v.data(), n);
+		for (size_t i = 0; i < n; i++) {
+			pubVec[i] = w[i];
+		}
+		normalizeVec(pubVec.data(), n);
+		for (size_t b = 0; b < blockSum.size(); b++) {
+			const size_t top = b * blockSize;
+			const size_t m = std::min(blockSize, n - top);
+			blockSum[b].clear();
+			for (size_t i = 0; i < m; i++) {
+				blockSum[b] += pubVec[top + i];
+			}
+		}
+		total.clear();
+		for (size_t b = 0; b < blockSum.size(); b++) {
+			total += blockSum[b];
+		}
+		normalizeVec(blockSum.data(), blockSum.size());
+	}
+	static size_t getBlockNum(size_t n, size_t blockSize)
+	{
+		if (blockSize == 0) throw cybozu::Exception("bls:CommitteeAggregator:bad blockSize");
+		return (n + blockSize - 1) / blockSize;
+	}
+	static bool getBit(const uint8_t *bitmap, size_t i)
+	{
+		return ((bitmap[i / 8] >> (i % 8)) & 1) != 0;
+	}
+	/*
+		start from 0 ; a block costs c (add the present keys) or 1 + m - c (add the sum and sub the absent keys)
+		start from total ; a block costs m - c (sub the absent keys) or 1 + c (sub the sum and add the present keys)
+		where c of m keys of the block are present
+	*/
+	size_t aggregate(G2& agg, const uint8_t *bitmap, size_t bitmapSize) const
+	{
+		if (bitmapSize != (n + 7) / 8) throw cybozu::Exception("bls:CommitteeAggregator:aggregate:bad bitmapSize") << bitmapSize << n;
+		if (n % 8 && (bitmap[bitmapSize - 1] >> (n % 8))) throw cybozu::Exception("bls:CommitteeAggregator:aggregate:bad unused bits");
+		const size_t blockN = blockSum.size();
+		std::vector<size_t> cVec(blockN);
+		size_t cost0 = 0;
+		size_t cost1 = 0;
+		for (size_t b = 0; b < blockN; b++) {
+			const size_t top = b * blockSize;
+			const size_t m = std::min(blockSize, n - top);
+			size_t c = 0;
+			for (size_t i = 0; i < m; i++) {
+				c += getBit(bitmap, top + i);
+			}
+			cVec[b] = c;
+			cost0 += std::min(c, 1 + m - c);
+			cost1 += std::min(m - c, 1 + c);
+		}
+		// + 1 for the copy of total prefers 0 on a tie ; it is not an addition
+		const bool fromTotal = cost1 + 1 < cost0;
+		if (fromTotal) {
+			agg = total;
+		} else {
+			agg.clear();
+		}
+		for (size_t b = 0; b < blockN; b++) {
+			const size_t top = b * blockSize;
+			const size_t m = std::min(blockSize, n - top);
+			const size_t c = cVec[b];
+			// add the present keys if true else sub the absent keys
+			bool addPresent;
+			if (fromTotal) {
+				if (c == m) continue;
+				addPresent = 1 + c < m - c;
+				if (addPresent) agg -= blockSum[b];
+			} else {
+				if (c == 0) continue;
+				addPresent = c <= 1 + m - c;
+				if (!addPresent) agg += blockSum[b];
+			}
+			for (size_t i = 0; i < m; i++) {
+				if (getBit(bitmap, top + i) == addPresent) {
+					if (addPresent) {
+						agg += pubVec[top + i];
+					} else {
+						agg -= pubVec[top + i];
+					}
+				}
+			}
+		}
+		return fromTotal ? cost1 : cost0;
+	}
+};
+
+struct MessageHasher {
+	cybozu::crypto::Hash h;
+	MessageHasher() : h(cybozu::crypto::Hash::N_SHA256) {}
+	/*
+		P = H(m) for m given by update() and reset h
+	*/
+	void final(G1& P)
+	{
+		const std::string digest = h.digest("", 0);
+		h.reset();
+		mapDigestToG1(P, digest);
+	}
+};
+
+struct PreparedPublicKey {
+	G2 sQ;
+	std::vector<Fp6> Qcoeff; // precomputeG2(sQ)
+	void set(const G2& Q)
+	{
+		sQ = Q;
+		BN::precomputeG2(Qcoeff, sQ);
+	}
+};
+
+} // mcl::bls::impl
+
+/*
+	delta[i] = delta_{i,S}(0) = prod_{j != i} S[j] / (S[j] - S[i]) = a / b
+	where a = prod S[j], b = S[i] * prod_{j != i} (S[j] - S[i])
+	1/b are computed by one inversion
+*/
+template<class V>
+void getLagrangeCoeff(FrVec& delta, const V& S)
+{
+	const size_t k = S.size();
+	FrVec b(k);
+	Fr a = S[0];
+	for (size_t i = 1; i < k; i++) {
+		a *= S[i];
+	}
+	for (size_t i = 0; i < k; i++) {
+		b[i] = S[i];
+		for (size_t j = 0; j < k; j++) {
+			if (j != i) {
+				Fr v = S[j] - S[i];
+				if (v.isZero()) throw cybozu::Exception("bls:LagrangeInterpolation:S has same id") << i << j;
+				b[i] *= v;
+			}
+		}
+	}
+	if (a.isZero()) throw cybozu::Exception("bls:LagrangeInterpolation:S has zero");
+	invVec(delta, b);
+	for (size_t i = 0; i < k; i++) {
+		delta[i] *= a;
+	}
+}
+
+/*
+	recover f(0) by { (x, y) | x = S[i], y = f(x) = vec[i] }
+*/
+template<class G, class V1, class V2>
+void LagrangeInterpolation(G& r, const V1& vec, const V2& S, const impl::LagrangeContext *ctx = 0)
+{
+	const size_t k = S.size();
+	if (vec.size() != k) throw cybozu::Exception("bls:LagrangeInterpolation:bad size") << vec.size() << k;
+	if (k < 2) throw cybozu::Exception("bls:LagrangeInterpolation:too small size") << k;
+	FrVec delta;
+	if (ctx) {
+		ctx->getCoeff(delta, S);
+	} else {
+		getLagrangeCoeff(delta, S);
+	}
+	/*
+		f(0) = sum_i f(S[i]) delta_{i,S}(0)
+	*/
+	mulVecG(r, vec, delta, k);
+}
+
+template<class T>
+std::ostream& writeAsHex(std::ostream& os, const T& t)
+{
+	BLS_STATS_SCOPE(StatsGetStr);
+	std::string str;
+	t.getStr(str, mcl::IoHexPrefix);
+	return os << str;
+}
+
+/*
+	fixed-size serialization
+	an element of Fr or Fp is keySize * 8 bytes little endian
+	a compressed point is its affine x (x.a then x.b for Fp2)
+	and the top two bits of the last byte, which are always zero for x < p, are the flags
+	an uncompressed point is its affine x with both flags and then y
+*/
+namespace ser {
+
+const size_t fpSize = keySize * 8;
+const uint8_t oddFlag = 0x80; // y is odd
+const uint8_t zeroFlag = 0x40; // the point at infinity
+const uint8_t uncompressedFlag = oddFlag | zeroFlag; // (x, y) follows
+
+struct Modulus {
+	uint64_t p[keySize];
+	uint64_t r[keySize];
+	void init()
+	{
+		glv::getArray(p, keySize, BN::param.p);
+		glv::getArray(r, keySize, BN::param.r);
+	}
+};
+
+static Modulus& getModulus()
+{
+	static Modulus m;
+	return m;
+}
+
+template<class F>
+void write(uint8_t *out, const F& x)
+{
+	uint64_t v[keySize];
+	getScalarArray(v, x);
+	for (size_t i = 0; i < fpSize; i++) {
+		out[i] = uint8_t(v[i / 8] >> ((i % 8) * 8));
+	}
+}
+
+/*
+	x = buf[0, fpSize) without the bits of flagMask in the last byte
+	return false if x >= m
+*/
+template<class F>
+bool read(F& x, const uint8_t *buf, const uint64_t *m, uint8_t flagMask = 0)
+{
+	uint64_t v[keySize] = {};
+	for (size_t i = 0; i < fpSize; i++) {
+		uint8_t c = buf[i];
+		if (i == fpSize - 1) c &= ~flagMask;
+		v[i / 8] |= uint64_t(c) << ((i % 8) * 8);
+	}
+	for (size_t i = keySize; i > 0;) {
+		i--;
+		if (v[i] < m[i]) break;
+		if (v[i] > m[i] || i == 0) return false;
+	}
+	x.setArray(v, keySize);
+	return true;
+}
+
+inline bool isOdd(const Fp& x)
+{
+	uint64_t v[keySize];
+	getScalarArray(v, x);
+	return (v[0] & 1) != 0;
+}
+
+/*
+	the sign of y = a + bi is that of a, or b if a = 0
+*/
+inline bool isOdd(const Fp2& x)
+{
+	return x.a.isZero() ? isOdd(x.b) : isOdd(x.a);
+}
+
+inline void writeElem(uint8_t *out, const Fp& x) { write(out, x); }
+inline void writeElem(uint8_t *out, const Fp2& x)
+{
+	write(out, x.a);
+	write(out + fpSize, x.b);
+}
+
+inline bool readElem(Fp& x, const uint8_t *buf, uint8_t flagMask)
+{
+	return read(x, buf, getModulus().p, flagMask);
+}
+inline bool readElem(Fp2& x, const uint8_t *buf, uint8_t flagMask)
+{
+	return read(x.a, buf, getModulus().p) && read(x.b, buf + fpSize, getModulus().p, flagMask);
+}
+
+/*
+	compressed ; out[0, size) = x with the flags where size = sizeof(x) / sizeof(Fp) * fpSize
+	uncompressed ; out[0, size * 2) = (x, y) with uncompressedFlag, and (0, 0) for the point at infinity
+*/
+template<class G>
+void serializePoint(uint8_t *out, const G& P, PointFormat format)
+{
+	const size_t size = sizeof(P.x) / sizeof(Fp) * fpSize;
+	if (P.isZero()) {
+		if (format == PointUncompressed) {
+			memset(out, 0, size * 2);
+			out[size - 1] = uncompressedFlag;
+		} else {
+			memset(out, 0, size);
+			out[size - 1] = zeroFlag;
+		}
+		return;
+	}
+	G T = P;
+	if (!T.z.isOne()) {
+		BLS_STATS_SCOPE(StatsNormalize);
+		T.normalize();
+	}
+	writeElem(out, T.x);
+	if (format == PointUncompressed) {
+		writeElem(out + size, T.y);
+		out[size - 1] |= uncompressedFlag;
+		return;
+	}
+	if (isOdd(T.y)) out[size - 1] |= oddFlag;
+}
+
+/*
+	the format is given by the flags of buf
+	compressed ; y^2 = x^3 + b is solved for y of the sign in buf
+	uncompressed ; P is checked to be on the curve if verifyCurve
+	the order of P is not checked
+*/
+template<class G>
+bool deserializePoint(G& P, const uint8_t *buf, size_t bufSize, bool verifyCurve = true)
+{
+	typedef decltype(P.x) F;
+	const size_t size = sizeof(P.x) / sizeof(Fp) * fpSize;
+	if (bufSize < size) return false;
+	const uint8_t flag = buf[size - 1] & uncompressedFlag;
+	if (flag == uncompressedFlag) {
+		if (bufSize != size * 2) return false;
+		F x, y;
+		if (!readElem(x, buf, uncompressedFlag) || !readElem(y, buf + size, 0)) return false;
+		if (x.isZero() && y.isZero()) {
+			P.clear();
+			return true;
+		}
+		if (verifyCurve) {
+			F t, y2;
+			G::getWeierstrass(t, x);
+			F::sqr(y2, y);
+			if (t != y2) return false;
+		}
+		P.x = x;
+		P.y = y;
+		P.z = 1;
+		return true;
+	}
+	if (bufSize != size) return false;
+	if (flag & zeroFlag) {
+		for (size_t i = 0; i < size - 1; i++) {
+			if (buf[i]) return false;
+		}
+		if (buf[size - 1] != zeroFlag) return false;
+		P.clear();
+		return true;
+	}
+	F x, y;
+	if (!readElem(x, buf, uncompressedFlag)) return false;
+	G::getWeierstrass(y, x);
+	if (!F::squareRoot(y, y)) return false;
+	if (isOdd(y) != ((flag & oddFlag) != 0)) F::neg(y, y);
+	P.x = x;
+	P.y = y;
+	P.z = 1;
+	return true;
+}
+
+/*
+	return true if r P = 0
+	double-and-add on the limbs of r, so it needs no mpz_class and does not allocate memory
+*/
+inline bool isOrderR(const G2& P)
+{
+	const uint64_t *r = getModulus().r;
+	G2 T;
+	T.clear();
+	for (size_t i = keySize * 64; i > 0;) {
+		i--;
+		G2::dbl(T, T);
+		if ((r[i / 64] >> (i % 64)) & 1) T += P;
+	}
+	return T.isZero();
+}
+
+} // bls::ser
+
+void init()
+{
+	BN::init(mcl::bn::CurveFp254BNb);
+	G1::setCompressedExpression();
+	G2::setCompressedExpression();
+	Fr::init(BN::param.r);
+	if (qtbl::fpUnitN != sizeof(Fp) / sizeof(uint64_t)) throw cybozu::Exception("bls:init:bad qtbl") << qtbl::fpUnitN;
+	getGLV1().set(*reinterpret_cast<const Fp*>(qtbl::glv1Beta), qtbl::glv1Int);
+	getGLS2().set(reinterpret_cast<const Fp2*>(qtbl::gls2G), qtbl::gls2Int);
+	ser::getModulus().init();
+//	mcl::setIoMode(mcl::IoHeximal);
+	assert(sizeof(Id) == sizeof(impl::Id));
+	assert(sizeof(SecretKey) == sizeof(impl::SecretKey));
+	assert(sizeof(PublicKey) == sizeof(impl::PublicKey));
+	assert(sizeof(Sign) == sizeof(impl::Sign));
+	assert(sizeof(AffinePublicKey) == sizeof(impl::AffinePublicKey));
+	assert(sizeof(AffineSign) == sizeof(impl::AffineSign));
+}
+
+void setPublicKeyTableWindow(size_t w)
+{
+	getMulQTable().set(w);
+}
+
+size_t getPublicKeyTableWindow()
+{
+	return getMulQTable().w;
+}
+
+size_t getPublicKeyTableMemorySize()
+{
+	return getMulQTable().getMemorySize();
+}
+
+void setHashCacheCapacity(size_t capacity)
+{
+	getHashCache().setMaxSize(capacity);
+	hashCacheEnabled = capacity > 0;
+}
+
+void getHashCacheStats(HashCacheStats& stats)
+{
+	LruCache<std::string, G1>& cache = getHashCache();
+	stats.capacity = cache.getMaxSize();
+	stats.size = cache.size();
+	stats.hitNum = cache.getHitNum();
+	stats.missNum = cache.getMissNum();
+}
+
+void clearHashCache()
+{
+	getHashCache().clear();
+}
+
+Id::Id(unsigned int id)
+{
+	getInner().v = id;
+}
+
+bool Id::operator==(const Id& rhs) const
+{
+	return getInner().v == rhs.getInner().v;
+}
+
+std::ostream& operator<<(std::ostream& os, const Id& id)
+{
+	return writeAsHex(os, id.getInner().v);
+}
+
+std::istream& operator>>(std::istream& is, Id& id)
 {
-	static cybozu::RandomGenerator rg;
-	return rg;
+	BLS_STATS_SCOPE(StatsSetStr);
+	return is >> id.getInner().v;
+}
+
+void Id::serialize(uint8_t *out) const
+{
+	BLS_STATS_SCOPE(StatsSerialize);
+	ser::write(out, getInner().v);
+}
+
+bool Id::deserialize(const uint8_t *buf, size_t bufSize)
+{
+	BLS_STATS_SCOPE(StatsDeserialize);
+	return bufSize == idSerializedSize && ser::read(getInner().v, buf, ser::getModulus().r);
+}
+
+bool Id::isZero() const
+{
+	return getInner().v.isZero();
+}
+
+void Id::set(const uint64_t *p)
+{
+	getInner().v.setArrayMask(p, keySize);
+}
+
+bool Sign::operator==(const Sign& rhs) const
+{
+	return getInner().sHm == rhs.getInner().sHm;
+}
+
+std::ostream& operator<<(std::ostream& os, const Sign& s)
+{
+	return writeAsHex(os, s.getInner().sHm);
+}
+
+std::istream& operator>>(std::istream& os, Sign& s)
+{
+	BLS_STATS_SCOPE(StatsSetStr);
+	return os >> s.getInner().sHm;
+}
+
+void Sign::serialize(uint8_t *out, PointFormat format) const
+{
+	BLS_STATS_SCOPE(StatsSerialize);
+	ser::serializePoint(out, getInner().sHm, format);
+}
+
+/*
+	the order of G1 is r then a point on the curve is in G1
+*/
+bool Sign::deserialize(const uint8_t *buf, size_t bufSize)
+{
+	BLS_STATS_SCOPE(StatsDeserialize);
+	return ser::deserializePoint(getInner().sHm, buf, bufSize);
+}
+
+/*
+	e(Q, s Hm) e(sQ, -Hm) = 1
+	sQ is G2 or its precomputed coefficients
+*/
+template<class G>
+static bool verifyHm(const G1& sHm, const G& sQ, const G1& Hm)
+{
+	G1 t;
+	G1::neg(t, Hm);
+	PairingCheck pc;
+	pc.add(getQcoeff(), sHm);
+	pc.add(sQ, t);
+	return pc.check();
+}
+
+static const std::vector<Fp6>& getPreparedCoeff(const impl::PreparedPublicKey& ppub)
+{
+	if (ppub.Qcoeff.empty()) throw cybozu::Exception("bls:Sign:verify:PreparedPublicKey is not set");
+	return ppub.Qcoeff;
+}
+
+bool Sign::verify(const PublicKey& pub, const std::string& m) const
+{
+	return verify(pub, m.data(), m.size());
+}
+
+bool Sign::verify(const PublicKey& pub, const void *m, size_t mSize) const
+{
+	G1 Hm;
+	HashAndMapToG1(Hm, m, mSize); // Hm = Hash(m)
+	return verifyHm(getInner().sHm, pub.getInner().sQ, Hm);
+}
+
+bool Sign::verify(const PreparedPublicKey& ppub, const std::string& m) const
+{
+	return verify(ppub, m.data(), m.size());
+}
+
+bool Sign::verify(const PreparedPublicKey& ppub, const void *m, size_t mSize) const
+{
+	const std::vector<Fp6>& Qcoeff = getPreparedCoeff(*ppub.self_);
+	G1 Hm;
+	HashAndMapToG1(Hm, m, mSize);
+	return verifyHm(getInner().sHm, Qcoeff, Hm);
+}
+
+bool Sign::verify(const PublicKey& pub, MessageHasher& h) const
+{
+	G1 Hm;
+	h.self_->final(Hm);
+	return verifyHm(getInner().sHm, pub.getInner().sQ, Hm);
+}
+
+bool Sign::verify(const PreparedPublicKey& ppub, MessageHasher& h) const
+{
+	const std::vector<Fp6>& Qcoeff = getPreparedCoeff(*ppub.self_);
+	G1 Hm;
+	h.self_->final(Hm);
+	return verifyHm(getInner().sHm, Qcoeff, Hm);
+}
+
+bool Sign::verify(const PublicKey& pub) const
+{
+	std::string str;
+	pub.getInner().sQ.getStr(str);
+	return verify(pub, str);
+}
+
+/*
+	the i-th message is (data(i), size(i))
+*/
+struct StrMsgVec {
+	const std::string *v;
+	explicit StrMsgVec(const std::string *v) : v(v) {}
+	const char *data(size_t i) const { return v[i].data(); }
+	size_t size(size_t i) const { return v[i].size(); }
+};
+
+struct PtrMsgVec {
+	const char *const *v;
+	const size_t *sizeVec;
+	PtrMsgVec(const char *const *v, const size_t *sizeVec) : v(v), sizeVec(sizeVec) {}
+	const char *data(size_t i) const { return v[i]; }
+	size_t size(size_t i) const { return sizeVec[i]; }
+};
+
+/*
+	compare the messages lexicographically
+*/
+template<class MsgVec>
+struct LessMsg {
+	const MsgVec& msgVec;
+	explicit LessMsg(const MsgVec& msgVec) : msgVec(msgVec) {}
+	bool operator()(size_t a, size_t b) const
+	{
+		const size_t aSize = msgVec.size(a);
+		const size_t bSize = msgVec.size(b);
+		int c = memcmp(msgVec.data(a), msgVec.data(b), std::min(aSize, bSize));
+		return c < 0 || (c == 0 && aSize < bSize);
+	}
+};
+
+/*
+	e(Q, sHm) prod_i e(pub_i, -H(m_i)) = 1
+*/
+template<class MsgVec>
+static bool verifyAggregateG(const G1& sHm, const PublicKey *pubVec, const MsgVec& msgVec, size_t n)
+{
+	if (n == 0) return false;
+	/*
+		the messages must be distinct
+		otherwise the aggregated sign is forgeable by a rogue public key
+	*/
+	{
+		std::vector<size_t> v(n);
+		for (size_t i = 0; i < n; i++) {
+			v[i] = i;
+		}
+		const LessMsg<MsgVec> less(msgVec);
+		std::sort(v.begin(), v.end(), less);
+		for (size_t i = 1; i < n; i++) {
+			if (!less(v[i - 1], v[i])) return false;
+		}
+	}
+	const WrapArray<PublicKey, G2> pubW(pubVec, n);
+	PairingCheck pc;
+	pc.reserve(n + 1);
+	pc.add(getQcoeff(), sHm);
+	G1 Hm;
+	for (size_t i = 0; i < n; i++) {
+		HashAndMapToG1(Hm, msgVec.data(i), msgVec.size(i));
+		G1::neg(Hm, Hm);
+		pc.add(pubW[i], Hm);
+	}
+	return pc.check();
+}
+
+bool Sign::verifyAggregate(const PublicKey *pubVec, const std::string *msgVec, size_t n) const
+{
+	return verifyAggregateG(getInner().sHm, pubVec, StrMsgVec(msgVec), n);
+}
+
+bool Sign::verifyAggregate(const PublicKey *pubVec, const char *const *msgVec, const size_t *msgSizeVec, size_t n) const
+{
+	return verifyAggregateG(getInner().sHm, pubVec, PtrMsgVec(msgVec, msgSizeVec), n);
+}
+
+struct BatchVerifier {
+	WrapArray<Sign, G1> signW;
+	WrapArray<PublicKey, G2> pubW;
+	std::vector<G1> HmVec;
+	ThreadPool *pool;
+	template<class MsgVec>
+	BatchVerifier(const Sign *signVec, const PublicKey *pubVec, const MsgVec& msgVec, size_t n, ThreadPool *pool)
+		: signW(signVec, n)
+		, pubW(pubVec, n)
+		, HmVec(n)
+		, pool(pool)
+	{
+		parallelFor(pool, n, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				HashAndMapToG1(HmVec[i], msgVec.data(i), msgVec.size(i));
+			}
+		});
+	}
+	/*
+		r_i is a random randBit-bit integer, so an invalid batch passes with probability 2^-randBit
+	*/
+	static const size_t randBit = 64;
+	/*
+		check [begin, end) of the batch with random r_i
+		e(Q, sum_i r_i sign_i) prod_i e(pub_i, -r_i Hm_i) = 1
+		sum_i r_i sign_i is a multi-scalar multiplication and r_i Hm_i is G1::mul of a short scalar
+	*/
+	bool check(size_t begin, size_t end) const
+	{
+		const size_t n = end - begin;
+		PairingCheck pc;
+		pc.reserve(n + 1);
+		G1 sum, t;
+		if (n == 1) {
+			// r = 1 is enough for a single triple
+			sum = signW[begin];
+			G1::neg(t, HmVec[begin]);
+			pc.add(pubW[begin], t);
+		} else {
+			std::vector<uint64_t> sv(n * keySize);
+			std::vector<G1> sVec(n), PVec(n);
+			for (size_t i = 0; i < n; i++) {
+				readRand(&sv[i * keySize], randBit / 8);
+				sVec[i] = signW[begin + i];
+			}
+			parallelFor(pool, n, [&](size_t b, size_t e) {
+				Fr r;
+				for (size_t i = b; i < e; i++) {
+					r.setArray(&sv[i * keySize], keySize);
+					G1::mul(PVec[i], HmVec[begin + i], r);
+					G1::neg(PVec[i], PVec[i]);
+				}
+			});
+			mulVecBucket(sum, sVec, sv, randBit);
+			for (size_t i = 0; i < n; i++) {
+				pc.add(pubW[begin + i], PVec[i]);
+			}
+		}
+		pc.add(getQcoeff(), sum);
+		return pc.check(pool);
+	}
+	/*
+		[begin, end) is known to contain at least one invalid triple
+	*/
+	void findInvalid(std::vector<size_t>& badIdxVec, size_t begin, size_t end) const
+	{
+		if (end - begin == 1) {
+			badIdxVec.push_back(begin);
+			return;
+		}
+		const size_t mid = (begin + end) / 2;
+		if (check(begin, mid)) {
+			// then [mid, end) must contain an invalid one
+			findInvalid(badIdxVec, mid, end);
+			return;
+		}
+		findInvalid(badIdxVec, begin, mid);
+		if (!check(mid, end)) {
+			findInvalid(badIdxVec, mid, end);
+		}
+	}
+};
+
+template<class MsgVec>
+static bool verifyBatchG(const Sign *signVec, const PublicKey *pubVec, const MsgVec& msgVec, size_t n, std::vector<size_t> *badIdxVec, ThreadPool *pool)
+{
+	if (badIdxVec) badIdxVec->clear();
+	if (n == 0) return true;
+	BatchVerifier bv(signVec, pubVec, msgVec, n, pool);
+	if (bv.check(0, n)) return true;
+	if (badIdxVec) {
+		bv.findInvalid(*badIdxVec, 0, n);
+	}
+	return false;
+}
+
+bool verifyBatch(const Sign *signVec, const PublicKey *pubVec, const std::string *msgVec, size_t n, std::vector<size_t> *badIdxVec, ThreadPool *pool)
+{
+	return verifyBatchG(signVec, pubVec, StrMsgVec(msgVec), n, badIdxVec, pool);
+}
+
+bool verifyBatch(const Sign *signVec, const PublicKey *pubVec, const char *const *msgVec, const size_t *msgSizeVec, size_t n, std::vector<size_t> *badIdxVec, ThreadPool *pool)
+{
+	return verifyBatchG(signVec, pubVec, PtrMsgVec(msgVec, msgSizeVec), n, badIdxVec, pool);
+}
+
+template<class MsgVec>
+static void signBatchG(Sign *signVec, const SecretKey& sec, const MsgVec& msgVec, size_t n, ThreadPool *pool)
+{
+	parallelFor(pool, n, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			sec.sign(signVec[i], msgVec.data(i), msgVec.size(i));
+		}
+	});
+}
+
+void signBatch(Sign *signVec, const SecretKey& sec, const std::string *msgVec, size_t n, ThreadPool *pool)
+{
+	signBatchG(signVec, sec, StrMsgVec(msgVec), n, pool);
+}
+
+void signBatch(Sign *signVec, const SecretKey& sec, const char *const *msgVec, const size_t *msgSizeVec, size_t n, ThreadPool *pool)
+{
+	signBatchG(signVec, sec, PtrMsgVec(msgVec, msgSizeVec), n, pool);
+}
+
+void getPublicKeyBatch(PublicKey *pubVec, const SecretKey *secVec, size_t n, ThreadPool *pool)
+{
+	parallelFor(pool, n, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			secVec[i].getPublicKey(pubVec[i]);
+		}
+	});
+}
+
+/*
+	out[i] = f(x[i]) for begin <= i < end where f(x) = sum_j c[j] x^j of degree k - 1
+	if a run of x is consecutive and longer than k then
+	the first k values are given by evalPoly and the others by k - 1 additions
+	nabla[j] = nabla^j f(x) is updated to nabla^j f(x + 1) by
+	nabla[j] += nabla[j + 1] for j = k - 2, ..., 0
+*/
+template<class G, class Out, class C, class X>
+void evalPolyVec(const Out& out, const C& c, const X& x, size_t begin, size_t end)
+{
+	const size_t k = c.size();
+	const Fr one = 1;
+	std::vector<G> nabla;
+	size_t i = begin;
+	while (i < end) {
+		size_t m = 1;
+		while (i + m < end && x[i + m] == x[i + m - 1] + one) m++;
+		const size_t headNum = std::min(m, k);
+		for (size_t j = 0; j < headNum; j++) {
+			evalPoly(out[i + j], x[i + j], c);
+		}
+		if (m > k) {
+			// nabla[j] = nabla^j f(x[i + k - 1]) by the difference table of the first k values
+			nabla.resize(k);
+			std::vector<G> d(k);
+			for (size_t j = 0; j < k; j++) {
+				d[j] = out[i + j];
+			}
+			nabla[0] = d[k - 1];
+			for (size_t j = 1; j < k; j++) {
+				for (size_t t = k - 1; t >= j; t--) {
+					G::sub(d[t], d[t], d[t - 1]);
+				}
+				nabla[j] = d[k - 1];
+			}
+			for (size_t j = k; j < m; j++) {
+				for (size_t t = k - 1; t > 0; t--) {
+					G::add(nabla[t - 1], nabla[t - 1], nabla[t]);
+				}
+				out[i + j] = nabla[0];
+			}
+		}
+		i += m;
+	}
+}
+
+/*
+	split [0, n) into ranges long enough for the differences of evalPolyVec
+*/
+template<class G, class Out, class C, class X>
+void evalPolyVec(const Out& out, const C& c, const X& x, size_t n, ThreadPool *pool)
+{
+	size_t grainSize = 0;
+	if (pool) {
+		const size_t threadNum = pool->getThreadNum();
+		grainSize = std::max((n + threadNum * 4 - 1) / (threadNum * 4), c.size() * 4);
+	}
+	parallelFor(pool, n, [&](size_t begin, size_t end) {
+		evalPolyVec<G>(out, c, x, begin, end);
+	}, grainSize);
+}
+
+void deriveSecretShares(const SecretKeyVec& msk, const Id *idVec, size_t n, SecretKey *out, ThreadPool *pool)
+{
+	WrapArray<SecretKey, Fr> c(msk.data(), msk.size());
+	evalPolyVec<Fr>(WrapOutArray<SecretKey, Fr>(out), c, WrapArray<Id, Fr>(idVec, n), n, pool);
+}
+
+void derivePublicShares(const PublicKeyVec& mpk, const Id *idVec, size_t n, PublicKey *out, ThreadPool *pool)
+{
+	WrapArray<PublicKey, G2> c(mpk.data(), mpk.size());
+	evalPolyVec<G2>(WrapOutArray<PublicKey, G2>(out), c, WrapArray<Id, Fr>(idVec, n), n, pool);
+}
+
+void Sign::recover(const SignVec& signVec, const IdVec& idVec)
+{
+	if (signVec.size() != idVec.size()) throw cybozu::Exception("Sign:recover:bad size") << signVec.size() << idVec.size();
+	recover(signVec.data(), idVec.data(), signVec.size());
+}
+
+void Sign::recover(const Sign* signVec, const Id *idVec, size_t n)
+{
+	WrapArray<Sign, G1> signW(signVec, n);
+	WrapArray<Id, Fr> idW(idVec, n);
+	LagrangeInterpolation(getInner().sHm, signW, idW);
+}
+
+void Sign::recover(const SignVec& signVec, const IdVec& idVec, const LagrangeContext& ctx)
+{
+	if (signVec.size() != idVec.size()) throw cybozu::Exception("Sign:recover:bad size") << signVec.size() << idVec.size();
+	recover(signVec.data(), idVec.data(), signVec.size(), ctx);
+}
+
+void Sign::recover(const Sign* signVec, const Id *idVec, size_t n, const LagrangeContext& ctx)
+{
+	WrapArray<Sign, G1> signW(signVec, n);
+	WrapArray<Id, Fr> idW(idVec, n);
+	LagrangeInterpolation(getInner().sHm, signW, idW, ctx.self_);
+}
+
+void Sign::add(const Sign& rhs)
+{
+	getInner().sHm += rhs.getInner().sHm;
+}
+
+void Sign::setHashOf(const void *m, size_t mSize)
+{
+	HashAndMapToG1(getInner().sHm, m, mSize);
+}
+
+void Sign::normalize()
+{
+	BLS_STATS_SCOPE(StatsNormalize);
+	getInner().sHm.normalize();
+}
+
+void Sign::aggregate(const Sign *signVec, size_t n, ThreadPool *pool)
+{
+	aggregateG(getInner().sHm, WrapArray<Sign, G1>(signVec, n), n, pool);
+}
+
+void Sign::aggregate(const AffineSign *signVec, size_t n, ThreadPool *pool)
+{
+	sumAffine(getInner().sHm, reinterpret_cast<const impl::AffineSign*>(signVec), n, pool);
+}
+
+bool PublicKey::operator==(const PublicKey& rhs) const
+{
+	return getInner().sQ == rhs.getInner().sQ;
+}
+
+std::ostream& operator<<(std::ostream& os, const PublicKey& pub)
+{
+	return writeAsHex(os, pub.getInner().sQ);
+}
+
+std::istream& operator>>(std::istream& is, PublicKey& pub)
+{
+	BLS_STATS_SCOPE(StatsSetStr);
+	return is >> pub.getInner().sQ;
+}
+
+void PublicKey::serialize(uint8_t *out, PointFormat format) const
+{
+	BLS_STATS_SCOPE(StatsSerialize);
+	ser::serializePoint(out, getInner().sQ, format);
+}
+
+/*
+	the twist curve has points of order other than r then check r sQ = 0
+*/
+bool PublicKey::deserialize(const uint8_t *buf, size_t bufSize, DeserializeMode mode)
+{
+	BLS_STATS_SCOPE(StatsDeserialize);
+	G2& sQ = getInner().sQ;
+	if (!ser::deserializePoint(sQ, buf, bufSize, mode == DeserializeChecked)) return false;
+	if (mode == DeserializeTrusted) return true;
+	if (ser::isOrderR(sQ)) return true;
+	sQ.clear();
+	return false;
+}
+
+void PublicKey::set(const PublicKey *mpk, size_t k, const Id& id)
+{
+	WrapArray<PublicKey, G2> w(mpk, k);
+	evalPoly(getInner().sQ, id.getInner().v, w);
+}
+
+void PublicKey::recover(const PublicKeyVec& pubVec, const IdVec& idVec)
+{
+	if (pubVec.size() != idVec.size()) throw cybozu::Exception("PublicKey:recover:bad size") << pubVec.size() << idVec.size();
+	recover(pubVec.data(), idVec.data(), pubVec.size());
+}
+void PublicKey::recover(const PublicKey *pubVec, const Id *idVec, size_t n)
+{
+	WrapArray<PublicKey, G2> pubW(pubVec, n);
+	WrapArray<Id, Fr> idW(idVec, n);
+	LagrangeInterpolation(getInner().sQ, pubW, idW);
 }
 
-namespace bls {
-
-static const G2& getQ()
+void PublicKey::recover(const PublicKeyVec& pubVec, const IdVec& idVec, const LagrangeContext& ctx)
 {
-	static const G2 Q(
-		Fp2("12723517038133731887338407189719511622662176727675373276651903807414909099441", "4168783608814932154536427934509895782246573715297911553964171371032945126671"),
-		Fp2("13891744915211034074451795021214165905772212241412891944830863846330766296736", "7937318970632701341203597196594272556916396164729705624521405069090520231616")
-	);
-	return Q;
+	if (pubVec.size() != idVec.size()) throw cybozu::Exception("PublicKey:recover:bad size") << pubVec.size() << idVec.size();
+	recover(pubVec.data(), idVec.data(), pubVec.size(), ctx);
 }
-
-static void mapToG1(G1& P, const Fp& t)
+void PublicKey::recover(const PublicKey *pubVec, const Id *idVec, size_t n, const LagrangeContext& ctx)
 {
-	static mcl::bn::MapTo<Fp> mapTo;
-	mapTo.calcG1(P, t);
+	WrapArray<PublicKey, G2> pubW(pubVec, n);
+	WrapArray<Id, Fr> idW(idVec, n);
+	LagrangeInterpolation(getInner().sQ, pubW, idW, ctx.self_);
 }
 
-static void HashAndMapToG1(G1& P, const std::string& m)
+void PublicKey::add(const PublicKey& rhs)
 {
-	std::string digest = cybozu::crypto::Hash::digest(cybozu::crypto::Hash::N_SHA256, m);
-	Fp t;
-	t.setArrayMask(digest.c_str(), digest.size());
-	mapToG1(P, t);
+	getInner().sQ += rhs.getInner().sQ;
 }
 
-template<class T, class G, class Vec>
-void evalPoly(G& y, const T& x, const Vec& c)
+void PublicKey::normalize()
 {
-	if (c.size() < 2) throw cybozu::Exception("bls:evalPoly:bad size") << c.size();
-	y = c[c.size() - 1];
-	for (int i = (int)c.size() - 2; i >= 0; i--) {
-		G::mul(y, y, x);
-		G::add(y, y, c[i]);
-	}
+	BLS_STATS_SCOPE(StatsNormalize);
+	getInner().sQ.normalize();
 }
 
-template<class T, class G>
-struct WrapArray {
-	const T *v;
-	size_t k;
-	WrapArray(const T *v, size_t k) : v(v), k(k) {}
-	const G& operator[](size_t i) const
-	{
-		return v[i].getInner().get();
-	}
-	size_t size() const { return k; }
-};
-
-struct Polynomial {
-	FrVec c; // f[x] = sum_{i=0}^{k-1} c[i] x^i
-	void init(const Fr& s, int k)
-	{
-		if (k < 2) throw cybozu::Exception("bls:Polynomial:init:bad k") << k;
-		c.resize(k);
-		c[0] = s;
-		for (size_t i = 1; i < c.size(); i++) {
-			c[i].setRand(getRG());
-		}
-	}
-	// y = f(id)
-	void eval(Fr& y, const Fr& id) const
-	{
-		if (id.isZero()) throw cybozu::Exception("bls:Polynomial:eval:id is zero");
-		evalPoly(y, id, c);
-	}
-};
-
-namespace impl {
+void PublicKey::aggregate(const PublicKey *pubVec, size_t n, ThreadPool *pool)
+{
+	aggregateG(getInner().sQ, WrapArray<PublicKey, G2>(pubVec, n), n, pool);
+}
 
-struct Id {
-	Fr v;
-	const Fr& get() const { return v; }
-};
+void PublicKey::aggregate(const AffinePublicKey *pubVec, size_t n, ThreadPool *pool)
+{
+	sumAffine(getInner().sQ, reinterpret_cast<const impl::AffinePublicKey*>(pubVec), n, pool);
+}
 
-struct SecretKey {
-	Fr s;
-	const Fr& get() const { return s; }
-};
+PreparedPublicKey::PreparedPublicKey()
+	: self_(new impl::PreparedPublicKey())
+{
+	self_->sQ.clear();
+}
 
-struct Sign {
-	G1 sHm; // s Hash(m)
-	const G1& get() const { return sHm; }
-};
+PreparedPublicKey::PreparedPublicKey(const PublicKey& pub)
+	: self_(new impl::PreparedPublicKey())
+{
+	set(pub);
+}
 
-struct PublicKey {
-	G2 sQ;
-	const G2& get() const { return sQ; }
-	void getStr(std::string& str) const
-	{
-		sQ.getStr(str, mcl::IoArrayRaw);
-	}
-};
+PreparedPublicKey::PreparedPublicKey(const PreparedPublicKey& rhs)
+	: self_(new impl::PreparedPublicKey(*rhs.self_))
+{
+}
 
-} // mcl::bls::impl
+PreparedPublicKey& PreparedPublicKey::operator=(const PreparedPublicKey& rhs)
+{
+	*self_ = *rhs.self_;
+	return *this;
+}
 
-/*
-	recover f(0) by { (x, y) | x = S[i], y = f(x) = vec[i] }
-*/
-template<class G, class V1, class V2>
-void LagrangeInterpolation(G& r, const V1& vec, const V2& S)
+PreparedPublicKey::~PreparedPublicKey()
 {
-	/*
-		delta_{i,S}(0) = prod_{j != i} S[j] / (S[j] - S[i]) = a / b
-		where a = prod S[j], b = S[i] * prod_{j != i} (S[j] - S[i])
-	*/
-	const size_t k = S.size();
-	if (vec.size() != k) throw cybozu::Exception("bls:LagrangeInterpolation:bad size") << vec.size() << k;
-	if (k < 2) throw cybozu::Exception("bls:LagrangeInterpolation:too small size") << k;
-	FrVec delta(k);
-	Fr a = S[0];
-	for (size_t i = 1; i < k; i++) {
-		a *= S[i];
-	}
-	for (size_t i = 0; i < k; i++) {
-		Fr b = S[i];
-		for (size_t j = 0; j < k; j++) {
-			if (j != i) {
-				Fr v = S[j] - S[i];
-				if (v.isZero()) throw cybozu::Exception("bls:LagrangeInterpolation:S has same id") << i << j;
-				b *= v;
-			}
-		}
-		delta[i] = a / b;
-	}
+	delete self_;
+}
 
-	/*
-		f(0) = sum_i f(S[i]) delta_{i,S}(0)
-	*/
-	r.clear();
-	G t;
-	for (size_t i = 0; i < delta.size(); i++) {
-		G::mul(t, vec[i], delta[i]);
-		r += t;
-	}
+void PreparedPublicKey::set(const PublicKey& pub)
+{
+	self_->set(pub.getInner().sQ);
 }
 
-template<class T>
-std::ostream& writeAsHex(std::ostream& os, const T& t)
+void PreparedPublicKey::getPublicKey(PublicKey& pub) const
 {
-	std::string str;
-	t.getStr(str, mcl::IoHexPrefix);
-	return os << str;
+	pub.getInner().sQ = self_->sQ;
 }
 
-void init()
+size_t PreparedPublicKey::getMemorySize() const
 {
-	BN::init(mcl::bn::CurveFp254BNb);
-	G1::setCompressedExpression();
-	G2::setCompressedExpression();
-	Fr::init(BN::param.r);
-//	mcl::setIoMode(mcl::IoHeximal);
-	assert(sizeof(Id) == sizeof(impl::Id));
-	assert(sizeof(SecretKey) == sizeof(impl::SecretKey));
-	assert(sizeof(PublicKey) == sizeof(impl::PublicKey));
-	assert(sizeof(Sign) == sizeof(impl::Sign));
+	return sizeof(*this) + sizeof(impl::PreparedPublicKey) + self_->Qcoeff.capacity() * sizeof(Fp6);
 }
 
-Id::Id(unsigned int id)
+/*
+	SHA-256 of the serialized pubVec[0, n) which are normalized
+	the Jacobian coordinates are not used because a point has many of them
+*/
+static std::string getDigest(const G2 *pubVec, size_t n)
 {
-	getInner().v = id;
+	cybozu::crypto::Hash h(cybozu::crypto::Hash::N_SHA256);
+	uint8_t buf[publicKeySerializedSize];
+	for (size_t i = 0; i < n; i++) {
+		ser::serializePoint(buf, pubVec[i], PointCompressed);
+		h.update(buf, sizeof(buf));
+	}
+	return h.digest(0, 0);
 }
 
-bool Id::operator==(const Id& rhs) const
+AggregatePublicKeyCache::AggregatePublicKeyCache(size_t maxSize)
+	: self_(new impl::AggregatePublicKeyCache(maxSize))
 {
-	return getInner().v == rhs.getInner().v;
 }
 
-std::ostream& operator<<(std::ostream& os, const Id& id)
+AggregatePublicKeyCache::~AggregatePublicKeyCache()
 {
-	return writeAsHex(os, id.getInner().v);
+	delete self_;
 }
 
-std::istream& operator>>(std::istream& is, Id& id)
+/*
+	the normalized copy of pubVec makes the key and the sum of a miss by mixed additions
+*/
+bool AggregatePublicKeyCache::get(PublicKey& agg, const PublicKey *pubVec, size_t n)
 {
-	return is >> id.getInner().v;
+	std::vector<G2> v(n);
+	for (size_t i = 0; i < n; i++) {
+		v[i] = pubVec[i].getInner().sQ;
+	}
+	normalizeVec(v.data(), n);
+	return self_->get(agg.getInner().sQ, getDigest(v.data(), n), v);
 }
 
-bool Id::isZero() const
+bool AggregatePublicKeyCache::get(PublicKey& agg, const std::string& key, const PublicKey *pubVec, size_t n)
 {
-	return getInner().v.isZero();
+	return self_->get(agg.getInner().sQ, key, WrapArray<PublicKey, G2>(pubVec, n));
 }
 
-void Id::set(const uint64_t *p)
+size_t AggregatePublicKeyCache::size() const
 {
-	getInner().v.setArrayMask(p, keySize);
+	return self_->cache.size();
 }
 
-bool Sign::operator==(const Sign& rhs) const
+void AggregatePublicKeyCache::clear()
 {
-	return getInner().sHm == rhs.getInner().sHm;
+	self_->cache.clear();
 }
 
-std::ostream& operator<<(std::ostream& os, const Sign& s)
+bool fastAggregateVerify(const Sign& sign, const PublicKey *pubVec, size_t n, const std::string& m, AggregatePublicKeyCache *cache)
 {
-	return writeAsHex(os, s.getInner().sHm);
+	return fastAggregateVerify(sign, pubVec, n, m.data(), m.size(), cache);
 }
 
-std::istream& operator>>(std::istream& os, Sign& s)
+bool fastAggregateVerify(const Sign& sign, const PublicKey *pubVec, size_t n, const void *m, size_t mSize, AggregatePublicKeyCache *cache)
 {
-	return os >> s.getInner().sHm;
+	if (n == 0) return false;
+	PublicKey agg;
+	if (cache) {
+		cache->get(agg, pubVec, n);
+	} else {
+		AggregatePublicKeyCache::aggregate(agg, pubVec, n);
+	}
+	return sign.verify(agg, m, mSize);
 }
 
-bool Sign::verify(const PublicKey& pub, const std::string& m) const
+void AggregatePublicKeyCache::aggregate(PublicKey& agg, const PublicKey *pubVec, size_t n, ThreadPool *pool)
 {
-	G1 Hm;
-	HashAndMapToG1(Hm, m); // Hm = Hash(m)
-	Fp12 e1, e2;
-	BN::pairing(e1, getQ(), getInner().sHm); // e(Q, s Hm)
-	BN::pairing(e2, pub.getInner().sQ, Hm); // e(sQ, Hm)
-	return e1 == e2;
+	impl::AggregatePublicKeyCache::aggregate(agg.getInner().sQ, WrapArray<PublicKey, G2>(pubVec, n), pool);
 }
 
-bool Sign::verify(const PublicKey& pub) const
+CommitteeAggregator::CommitteeAggregator(const PublicKeyVec& pubVec, size_t blockSize)
+	: self_(new impl::CommitteeAggregator(pubVec, blockSize))
 {
-	std::string str;
-	pub.getInner().sQ.getStr(str);
-	return verify(pub, str);
 }
 
-void Sign::recover(const SignVec& signVec, const IdVec& idVec)
+CommitteeAggregator::~CommitteeAggregator()
 {
-	if (signVec.size() != idVec.size()) throw cybozu::Exception("Sign:recover:bad size") << signVec.size() << idVec.size();
-	recover(signVec.data(), idVec.data(), signVec.size());
+	delete self_;
 }
 
-void Sign::recover(const Sign* signVec, const Id *idVec, size_t n)
+size_t CommitteeAggregator::size() const
 {
-	WrapArray<Sign, G1> signW(signVec, n);
-	WrapArray<Id, Fr> idW(idVec, n);
-	LagrangeInterpolation(getInner().sHm, signW, idW);
+	return self_->n;
 }
 
-void Sign::add(const Sign& rhs)
+size_t CommitteeAggregator::aggregate(PublicKey& agg, const uint8_t *bitmap, size_t bitmapSize) const
 {
-	getInner().sHm += rhs.getInner().sHm;
+	return self_->aggregate(agg.getInner().sQ, bitmap, bitmapSize);
 }
 
-bool PublicKey::operator==(const PublicKey& rhs) const
+LagrangeContext::LagrangeContext(size_t n)
+	: self_(new impl::LagrangeContext(n))
 {
-	return getInner().sQ == rhs.getInner().sQ;
 }
 
-std::ostream& operator<<(std::ostream& os, const PublicKey& pub)
+LagrangeContext::~LagrangeContext()
 {
-	return writeAsHex(os, pub.getInner().sQ);
+	delete self_;
 }
 
-std::istream& operator>>(std::istream& is, PublicKey& pub)
+size_t LagrangeContext::getN() const
 {
-	return is >> pub.getInner().sQ;
+	return self_->n;
 }
 
-void PublicKey::set(const PublicKey *mpk, size_t k, const Id& id)
+MessageHasher::MessageHasher()
+	: self_(new impl::MessageHasher())
 {
-	WrapArray<PublicKey, G2> w(mpk, k);
-	evalPoly(getInner().sQ, id.getInner().v, w);
 }
 
-void PublicKey::recover(const PublicKeyVec& pubVec, const IdVec& idVec)
+MessageHasher::~MessageHasher()
 {
-	if (pubVec.size() != idVec.size()) throw cybozu::Exception("PublicKey:recover:bad size") << pubVec.size() << idVec.size();
-	recover(pubVec.data(), idVec.data(), pubVec.size());
+	delete self_;
 }
-void PublicKey::recover(const PublicKey *pubVec, const Id *idVec, size_t n)
+
+void MessageHasher::update(const void *buf, size_t bufSize)
 {
-	WrapArray<PublicKey, G2> pubW(pubVec, n);
-	WrapArray<Id, Fr> idW(idVec, n);
-	LagrangeInterpolation(getInner().sQ, pubW, idW);
+	self_->h.update(buf, bufSize);
 }
 
-void PublicKey::add(const PublicKey& rhs)
+void MessageHasher::reset()
 {
-	getInner().sQ += rhs.getInner().sQ;
+	self_->h.reset();
 }
 
 bool SecretKey::operator==(const SecretKey& rhs) const
@@ -309,12 +2138,25 @@ std::ostream& operator<<(std::ostream& os, const SecretKey& sec)
 
 std::istream& operator>>(std::istream& is, SecretKey& sec)
 {
+	BLS_STATS_SCOPE(StatsSetStr);
 	return is >> sec.getInner().s;
 }
 
+void SecretKey::serialize(uint8_t *out) const
+{
+	BLS_STATS_SCOPE(StatsSerialize);
+	ser::write(out, getInner().s);
+}
+
+bool SecretKey::deserialize(const uint8_t *buf, size_t bufSize)
+{
+	BLS_STATS_SCOPE(StatsDeserialize);
+	return bufSize == secretKeySerializedSize && ser::read(getInner().s, buf, ser::getModulus().r);
+}
+
 void SecretKey::init()
 {
-	getInner().s.setRand(getRG());
+	setRandom(getInner().s);
 }
 
 void SecretKey::set(const uint64_t *p)
@@ -324,14 +2166,26 @@ void SecretKey::set(const uint64_t *p)
 
 void SecretKey::getPublicKey(PublicKey& pub) const
 {
-	G2::mul(pub.getInner().sQ, getQ(), getInner().s);
+	mulQ(pub.getInner().sQ, getInner().s);
 }
 
 void SecretKey::sign(Sign& sign, const std::string& m) const
+{
+	this->sign(sign, m.data(), m.size());
+}
+
+void SecretKey::sign(Sign& sign, const void *m, size_t mSize) const
+{
+	G1 Hm;
+	HashAndMapToG1(Hm, m, mSize);
+	mulG1(sign.getInner().sHm, Hm, getInner().s);
+}
+
+void SecretKey::sign(Sign& sign, MessageHasher& h) const
 {
 	G1 Hm;
-	HashAndMapToG1(Hm, m);
-	G1::mul(sign.getInner().sHm, Hm, getInner().s);
+	h.self_->final(Hm);
+	mulG1(sign.getInner().sHm, Hm, getInner().s);
 }
 
 void SecretKey::getPop(Sign& pop) const
@@ -371,9 +2225,105 @@ void SecretKey::recover(const SecretKey *secVec, const Id *idVec, size_t n)
 	LagrangeInterpolation(getInner().s, secW, idW);
 }
 
+void SecretKey::recover(const SecretKeyVec& secVec, const IdVec& idVec, const LagrangeContext& ctx)
+{
+	if (secVec.size() != idVec.size()) throw cybozu::Exception("SecretKey:recover:bad size") << secVec.size() << idVec.size();
+	recover(secVec.data(), idVec.data(), secVec.size(), ctx);
+}
+void SecretKey::recover(const SecretKey *secVec, const Id *idVec, size_t n, const LagrangeContext& ctx)
+{
+	WrapArray<SecretKey, Fr> secW(secVec, n);
+	WrapArray<Id, Fr> idW(idVec, n);
+	LagrangeInterpolation(getInner().s, secW, idW, ctx.self_);
+}
+
 void SecretKey::add(const SecretKey& rhs)
 {
 	getInner().s += rhs.getInner().s;
 }
 
+void mulVec(Sign& out, const Sign *signVec, const SecretKey *coeffVec, size_t n)
+{
+	mulVecG(out.getInner().sHm, WrapArray<Sign, G1>(signVec, n), WrapArray<SecretKey, Fr>(coeffVec, n), n);
+}
+
+void mulVec(PublicKey& out, const PublicKey *pubVec, const SecretKey *coeffVec, size_t n)
+{
+	mulVecG(out.getInner().sQ, WrapArray<PublicKey, G2>(pubVec, n), WrapArray<SecretKey, Fr>(coeffVec, n), n);
+}
+
+template<class T, class G>
+void normalizeVecT(T *vec, size_t n, ThreadPool *pool)
+{
+	parallelFor(pool, n, [&](size_t begin, size_t end) {
+		normalizeVec(&WrapArray<T, G>::get(vec[begin]), end - begin);
+	});
+}
+
+void normalizeVec(PublicKey *pubVec, size_t n, ThreadPool *pool)
+{
+	normalizeVecT<PublicKey, G2>(pubVec, n, pool);
+}
+
+void normalizeVec(Sign *signVec, size_t n, ThreadPool *pool)
+{
+	normalizeVecT<Sign, G1>(signVec, n, pool);
+}
+
+template<class A, class AI, class T, class G>
+void toAffineVecT(A *out, const T *vec, size_t n, ThreadPool *pool)
+{
+	WrapArray<T, G> w(vec, n);
+	parallelFor(pool, n, [&](size_t begin, size_t end) {
+		std::vector<G> v(end - begin);
+		for (size_t i = begin; i < end; i++) {
+			v[i - begin] = w[i];
+		}
+		normalizeVec(v.data(), v.size());
+		for (size_t i = begin; i < end; i++) {
+			getAffinePoint(WrapArray<A, AI>::get(out[i]), v[i - begin]);
+		}
+	});
+}
+
+void toAffineVec(AffinePublicKey *out, const PublicKey *pubVec, size_t n, ThreadPool *pool)
+{
+	toAffineVecT<AffinePublicKey, impl::AffinePublicKey, PublicKey, G2>(out, pubVec, n, pool);
+}
+
+void toAffineVec(AffineSign *out, const Sign *signVec, size_t n, ThreadPool *pool)
+{
+	toAffineVecT<AffineSign, impl::AffineSign, Sign, G1>(out, signVec, n, pool);
+}
+
+bool AffinePublicKey::operator==(const AffinePublicKey& rhs) const
+{
+	return getInner() == rhs.getInner();
+}
+
+void AffinePublicKey::set(const PublicKey& pub)
+{
+	toAffineVec(this, &pub, 1);
+}
+
+void AffinePublicKey::get(PublicKey& pub) const
+{
+	setAffinePoint(WrapArray<PublicKey, G2>::get(pub), getInner());
+}
+
+bool AffineSign::operator==(const AffineSign& rhs) const
+{
+	return getInner() == rhs.getInner();
+}
+
+void AffineSign::set(const Sign& sign)
+{
+	toAffineVec(this, &sign, 1);
+}
+
+void AffineSign::get(Sign& sign) const
+{
+	setAffinePoint(WrapArray<Sign, G1>::get(sign), getInner());
+}
+
 } // bls
@@ -0,0 +1,464 @@
+#pragma once
+/**
+	@file
+	@brief GLV method for G1 and GLS method for G2 of BN curve
+	@author MITSUNARI Shigeo(@herumi)
+	@license modified new BSD license
+	http://opensource.org/licenses/BSD-3-Clause
+*/
+#include <mcl/bn256.hpp>
+#include <cybozu/exception.hpp>
+#include <vector>
+#include <algorithm>
+
+namespace bls { namespace glv {
+
+typedef mcl::bn256::Fp Fp;
+typedef mcl::bn256::Fr Fr;
+typedef mcl::bn256::G1 G1;
+typedef mcl::bn256::Fp2 Fp2;
+typedef mcl::bn256::G2 G2;
+
+/*
+	y = x as an integer
+*/
+inline void getMpz(mpz_class& y, const Fr& x)
+{
+	mcl::fp::Block b;
+	x.getBlock(b);
+	mpz_import(y.get_mpz_t(), b.n, -1, sizeof(b.p[0]), 0, 0, b.p);
+}
+
+/*
+	x = the hexadecimal string s with an optional sign
+*/
+inline void setMpz(mpz_class& x, const char *s)
+{
+	if (x.set_str(s, 16) != 0) throw cybozu::Exception("bls:glv:setMpz:bad str") << s;
+}
+
+/*
+	y[0, n) = x for 0 <= x < 2^(64n)
+*/
+inline void getArray(uint64_t *y, size_t n, const mpz_class& x)
+{
+	for (size_t i = 0; i < n; i++) {
+		y[i] = 0;
+	}
+	size_t count = 0;
+	if (x == 0) return;
+	if (mpz_sizeinbase(x.get_mpz_t(), 2) > n * 64) throw cybozu::Exception("bls:glv:getArray:too large") << n;
+	mpz_export(y, &count, -1, sizeof(y[0]), 0, 0, x.get_mpz_t());
+}
+
+/*
+	q = round(x / r) = floor((2x + r) / 2r)
+*/
+inline void roundDiv(mpz_class& q, const mpz_class& x, const mpz_class& r)
+{
+	mpz_class t = x * 2 + r;
+	mpz_class d = r * 2;
+	mpz_fdiv_q(q.get_mpz_t(), t.get_mpz_t(), d.get_mpz_t());
+}
+
+/*
+	width-w NAF of x >= 0
+	x = sum_i naf[i] 2^i where naf[i] is 0 or odd and |naf[i]| < 2^(w-1)
+*/
+inline void getNaf(std::vector<int>& naf, const mpz_class& x, size_t w)
+{
+	naf.clear();
+	mpz_class t = x;
+	const int full = 1 << w;
+	const int half = 1 << (w - 1);
+	while (t != 0) {
+		int d = 0;
+		if (mpz_odd_p(t.get_mpz_t())) {
+			d = int(mpz_fdiv_ui(t.get_mpz_t(), full));
+			if (d >= half) d -= full;
+			t -= d;
+		}
+		naf.push_back(d);
+		t >>= 1;
+	}
+}
+
+/*
+	short basis v[i] = (a[i], b[i]) of the lattice { (a, b) | a + b lambda = 0 mod r }
+	by the extended Euclidean algorithm
+	k = k0 + k1 lambda mod r with |k0|, |k1| about sqrt(r)
+*/
+struct Lattice2 {
+	mpz_class a[2], b[2];
+	mpz_class det; // |a[0] b[1] - a[1] b[0]| = r
+	void init(const mpz_class& r, const mpz_class& lambda)
+	{
+		mpz_class sqrtR;
+		mpz_sqrt(sqrtR.get_mpz_t(), r.get_mpz_t());
+		// r_i = s_i r + t_i lambda
+		mpz_class r0 = r, r1 = lambda, t0 = 0, t1 = 1, q, tmp;
+		while (r1 >= sqrtR) {
+			q = r0 / r1;
+			tmp = r0 - q * r1; r0 = r1; r1 = tmp;
+			tmp = t0 - q * t1; t0 = t1; t1 = tmp;
+		}
+		// r0 >= sqrt(r) > r1
+		a[0] = r1;
+		b[0] = -t1;
+		q = r0 / r1;
+		const mpz_class r2 = r0 - q * r1;
+		const mpz_class t2 = t0 - q * t1;
+		if (r0 * r0 + t0 * t0 <= r2 * r2 + t2 * t2) {
+			a[1] = r0;
+			b[1] = -t0;
+		} else {
+			a[1] = r2;
+			b[1] = -t2;
+		}
+		det = a[0] * b[1] - a[1] * b[0];
+		if (det < 0) {
+			// swap v[0] and v[1] to make det positive
+			std::swap(a[0], a[1]);
+			std::swap(b[0], b[1]);
+			det = -det;
+		}
+	}
+	/*
+		(k0, k1) = (k, 0) - c0 v[0] - c1 v[1]
+		where (c0, c1) = round((k, 0) v^-1)
+	*/
+	void split(mpz_class& k0, mpz_class& k1, const mpz_class& k) const
+	{
+		mpz_class c0, c1;
+		roundDiv(c0, b[1] * k, det);
+		roundDiv(c1, -b[0] * k, det);
+		k0 = k - c0 * a[0] - c1 * a[1];
+		k1 = -c0 * b[0] - c1 * b[1];
+	}
+};
+
+/*
+	joint w-NAF multiplication
+	Q = sum_j k[j] tbl[j][0] where tbl[j][i] = (2i + 1) tbl[j][0] for 0 <= i < 2^(w-2)
+	tbl[j] is negated if k[j] < 0
+*/
+template<class G, size_t N, size_t tblN>
+void mulNaf(G& Q, G (&tbl)[N][tblN], mpz_class (&k)[N], size_t w)
+{
+	std::vector<int> naf[N];
+	size_t maxLen = 0;
+	for (size_t j = 0; j < N; j++) {
+		if (k[j] < 0) {
+			k[j] = -k[j];
+			for (size_t i = 0; i < tblN; i++) {
+				G::neg(tbl[j][i], tbl[j][i]);
+			}
+		}
+		getNaf(naf[j], k[j], w);
+		maxLen = std::max(maxLen, naf[j].size());
+	}
+	Q.clear();
+	for (size_t i = maxLen; i > 0; i--) {
+		G::dbl(Q, Q);
+		for (size_t j = 0; j < N; j++) {
+			if (i > naf[j].size()) continue;
+			const int d = naf[j][i - 1];
+			if (d > 0) {
+				G::add(Q, Q, tbl[j][(d - 1) / 2]);
+			} else if (d < 0) {
+				G::sub(Q, Q, tbl[j][(-d - 1) / 2]);
+			}
+		}
+	}
+}
+
+/*
+	g^((m - 1) / 3) mod m != 1 for the smallest g >= 2 ; a primitive cube root of unity
+*/
+inline void getCubeRoot(mpz_class& y, const mpz_class& m)
+{
+	const mpz_class e = (m - 1) / 3;
+	for (unsigned int g = 2; g < 100; g++) {
+		const mpz_class gg = g;
+		mpz_powm(y.get_mpz_t(), gg.get_mpz_t(), e.get_mpz_t(), m.get_mpz_t());
+		if (y != 1) return;
+	}
+	throw cybozu::Exception("bls:glv:getCubeRoot:not found");
+}
+
+/*
+	phi(x, y) = (beta x, y) is equal to lambda P for P in G1
+	x P = k0 P + k1 phi(P) where k0 and k1 are about 128-bit
+	and they are computed by the joint w-NAF
+*/
+struct GLV1 {
+	static const size_t w = 5;
+	static const size_t intN = 6;
+	Fp beta;
+	mpz_class lambda;
+	Lattice2 lattice;
+	/*
+		the integers made by init() ; lambda, a[0], a[1], b[0], b[1], det
+	*/
+	mpz_class *getInt(size_t i)
+	{
+		mpz_class *tbl[intN] = { &lambda, &lattice.a[0], &lattice.a[1], &lattice.b[0], &lattice.b[1], &lattice.det };
+		return tbl[i];
+	}
+	const mpz_class& getInt(size_t i) const { return *const_cast<GLV1*>(this)->getInt(i); }
+	/*
+		set the values made by init() at build time
+		intTbl[i] is getInt(i) as a hexadecimal string
+	*/
+	void set(const Fp& beta, const char *const *intTbl)
+	{
+		this->beta = beta;
+		for (size_t i = 0; i < intN; i++) {
+			setMpz(*getInt(i), intTbl[i]);
+		}
+	}
+	/*
+		P is a point of G1 to decide which lambda corresponds to beta
+	*/
+	void init(const mpz_class& r, const mpz_class& p, const G1& P)
+	{
+		mpz_class b;
+		getCubeRoot(b, p);
+		beta.setStr(b.get_str(), 10);
+		getCubeRoot(lambda, r);
+		G1 Q1, Q2;
+		mulLambda(Q1, P);
+		Fr t;
+		t.setStr(lambda.get_str(), 10);
+		G1::mul(Q2, P, t);
+		if (Q1 != Q2) {
+			// the other root lambda^2
+			lambda = (lambda * lambda) % r;
+			t.setStr(lambda.get_str(), 10);
+			G1::mul(Q2, P, t);
+			if (Q1 != Q2) throw cybozu::Exception("bls:glv:GLV1:init:bad lambda");
+		}
+		lattice.init(r, lambda);
+	}
+	/*
+		Q = phi(P) = lambda P
+		it is valid for Jacobian coordinates since x = X / Z^2
+	*/
+	void mulLambda(G1& Q, const G1& P) const
+	{
+		Fp::mul(Q.x, P.x, beta);
+		Q.y = P.y;
+		Q.z = P.z;
+	}
+	void split(mpz_class& k0, mpz_class& k1, const Fr& x) const
+	{
+		mpz_class k;
+		getMpz(k, x);
+		lattice.split(k0, k1, k);
+	}
+	void mul(G1& Q, const G1& P, const Fr& x) const
+	{
+		mpz_class k[2];
+		split(k[0], k[1], x);
+		const size_t tblN = size_t(1) << (w - 2);
+		// tbl[0][i] = (2i + 1)P, tbl[1][i] = phi(tbl[0][i])
+		G1 tbl[2][tblN];
+		G1 P2;
+		G1::dbl(P2, P);
+		tbl[0][0] = P;
+		for (size_t i = 1; i < tblN; i++) {
+			G1::add(tbl[0][i], tbl[0][i - 1], P2);
+		}
+		for (size_t i = 0; i < tblN; i++) {
+			mulLambda(tbl[1][i], tbl[0][i]);
+		}
+		mulNaf(Q, tbl, k, w);
+	}
+};
+
+/*
+	y = x^e
+*/
+inline void powFp2(Fp2& y, const Fp2& x, const mpz_class& e)
+{
+	const Fp2 t = x;
+	y.a = 1;
+	y.b = 0;
+	const size_t n = mpz_sizeinbase(e.get_mpz_t(), 2);
+	for (size_t i = n; i > 0; i--) {
+		Fp2::sqr(y, y);
+		if (mpz_tstbit(e.get_mpz_t(), i - 1)) Fp2::mul(y, y, t);
+	}
+}
+
+/*
+	y = x^p
+*/
+inline void frobenius(Fp2& y, const Fp2& x)
+{
+	y.a = x.a;
+	Fp::neg(y.b, x.b);
+}
+
+/*
+	psi(x, y) = (x^p gx, y^p gy) is untwist-Frobenius-twist
+	and it is equal to p Q for Q in G2
+	x Q = sum_{j < 4} k[j] psi^j(Q) where k[j] are about 64-bit
+	by the short basis of { v | sum_j v[j] p^j = 0 mod r } for BN curves
+	(z+1, z, z, -2z), (2z+1, -z, -(z+1), -z), (2z, 2z+1, 2z+1, 2z+1), (z-1, 4z+2, -2z+1, z-1)
+	where z is the BN parameter (Galbraith and Scott)
+*/
+struct GLS2 {
+	static const size_t w = 5;
+	static const size_t intN = 16 + 4 + 1;
+	Fp2 gx, gy;
+	mpz_class B[4][4];
+	mpz_class alpha[4]; // the first row of adj(B) ; (x, 0, 0, 0) B^-1 = x alpha / det
+	mpz_class det;
+	/*
+		the integers made by init() ; B[0][0], ..., B[3][3], alpha[0], ..., alpha[3], det
+	*/
+	mpz_class *getInt(size_t i)
+	{
+		if (i < 16) return &B[i / 4][i % 4];
+		if (i < 20) return &alpha[i - 16];
+		return &det;
+	}
+	const mpz_class& getInt(size_t i) const { return *const_cast<GLS2*>(this)->getInt(i); }
+	/*
+		set the values made by init() at build time
+		g[0] = gx, g[1] = gy and intTbl[i] is getInt(i) as a hexadecimal string
+	*/
+	void set(const Fp2 *g, const char *const *intTbl)
+	{
+		gx = g[0];
+		gy = g[1];
+		for (size_t i = 0; i < intN; i++) {
+			setMpz(*getInt(i), intTbl[i]);
+		}
+	}
+	static mpz_class det3(const mpz_class (&m)[4][4], size_t skipRow, size_t skipCol)
+	{
+		const mpz_class *v[3][3];
+		for (size_t i = 0, a = 0; i < 4; i++) {
+			if (i == skipRow) continue;
+			for (size_t j = 0, b = 0; j < 4; j++) {
+				if (j == skipCol) continue;
+				v[a][b++] = &m[i][j];
+			}
+			a++;
+		}
+		return *v[0][0] * (*v[1][1] * *v[2][2] - *v[1][2] * *v[2][1])
+			- *v[0][1] * (*v[1][0] * *v[2][2] - *v[1][2] * *v[2][0])
+			+ *v[0][2] * (*v[1][0] * *v[2][1] - *v[1][1] * *v[2][0]);
+	}
+	/*
+		xi is the parameter of the twist of the BN curve
+		Q is a point of G2 to decide the type of the twist
+	*/
+	void init(const mpz_class& r, const mpz_class& p, const mpz_class& z, const Fp2& xi, const G2& Q)
+	{
+		const mpz_class tbl[4][4] = {
+			{ z + 1, z, z, -2 * z },
+			{ 2 * z + 1, -z, -(z + 1), -z },
+			{ 2 * z, 2 * z + 1, 2 * z + 1, 2 * z + 1 },
+			{ z - 1, 4 * z + 2, -2 * z + 1, z - 1 },
+		};
+		const mpz_class lambda = p % r;
+		for (size_t i = 0; i < 4; i++) {
+			mpz_class t = 0;
+			for (size_t j = 4; j > 0; j--) {
+				t = (t * lambda + tbl[i][j - 1]) % r;
+			}
+			if (t != 0) throw cybozu::Exception("bls:glv:GLS2:init:bad basis") << i;
+			for (size_t j = 0; j < 4; j++) {
+				B[i][j] = tbl[i][j];
+			}
+		}
+		det = 0;
+		for (size_t j = 0; j < 4; j++) {
+			alpha[j] = det3(B, j, 0);
+			if (j & 1) alpha[j] = -alpha[j];
+			det += B[0][j] * ((j & 1) ? -det3(B, 0, j) : det3(B, 0, j));
+		}
+		if (det < 0) {
+			det = -det;
+			for (size_t j = 0; j < 4; j++) {
+				alpha[j] = -alpha[j];
+			}
+		}
+		/*
+			gx = xi^((p-1)/3), gy = xi^((p-1)/2) for D-type twist and their inverses for M-type
+			take the type which makes psi(Q) = p Q
+		*/
+		Fr t;
+		t.setStr(lambda.get_str(), 10);
+		G2 pQ, R;
+		G2::mul(pQ, Q, t);
+		powFp2(gx, xi, (p - 1) / 3);
+		powFp2(gy, xi, (p - 1) / 2);
+		for (int type = 0; type < 2; type++) {
+			if (type == 1) {
+				Fp2::inv(gx, gx);
+				Fp2::inv(gy, gy);
+			}
+			psi(R, Q);
+			if (R == pQ) return;
+		}
+		throw cybozu::Exception("bls:glv:GLS2:init:psi is not found");
+	}
+	/*
+		R = psi(Q)
+		it is valid for Jacobian coordinates since x = X / Z^2 and y = Y / Z^3
+	*/
+	void psi(G2& R, const G2& Q) const
+	{
+		frobenius(R.x, Q.x);
+		frobenius(R.y, Q.y);
+		frobenius(R.z, Q.z);
+		Fp2::mul(R.x, R.x, gx);
+		Fp2::mul(R.y, R.y, gy);
+	}
+	/*
+		(k[0], ..., k[3]) = (x, 0, 0, 0) - sum_j c[j] B[j]
+		where c[j] = round(x alpha[j] / det)
+	*/
+	void split(mpz_class (&k)[4], const Fr& x) const
+	{
+		mpz_class v;
+		getMpz(v, x);
+		k[0] = v;
+		for (size_t i = 1; i < 4; i++) {
+			k[i] = 0;
+		}
+		mpz_class c;
+		for (size_t j = 0; j < 4; j++) {
+			roundDiv(c, v * alpha[j], det);
+			for (size_t i = 0; i < 4; i++) {
+				k[i] -= c * B[j][i];
+			}
+		}
+	}
+	void mul(G2& R, const G2& Q, const Fr& x) const
+	{
+		mpz_class k[4];
+		split(k, x);
+		const size_t tblN = size_t(1) << (w - 2);
+		// tbl[0][i] = (2i + 1)Q, tbl[j][i] = psi(tbl[j - 1][i])
+		G2 tbl[4][tblN];
+		G2 Q2;
+		G2::dbl(Q2, Q);
+		tbl[0][0] = Q;
+		for (size_t i = 1; i < tblN; i++) {
+			G2::add(tbl[0][i], tbl[0][i - 1], Q2);
+		}
+		for (size_t j = 1; j < 4; j++) {
+			for (size_t i = 0; i < tblN; i++) {
+				psi(tbl[j][i], tbl[j - 1][i]);
+			}
+		}
+		mulNaf(R, tbl, k, w);
+	}
+};
+
+} } // bls::glv
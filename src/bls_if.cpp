@@ -3,6 +3,7 @@
 #include <iostream>
 #include <sstream>
 #include <memory.h>
+#include <algorithm>
 
 template<class Inner, class Outer>
 Outer *createT()
@@ -43,11 +44,38 @@ size_t getStrT(const Outer *p, char *buf, size_t maxBufSize)
 	return 0;
 }
 
+template<class Inner, class Outer>
+size_t serializeT(const Outer *p, uint8_t *buf, size_t maxBufSize, size_t size)
+{
+	if (size > maxBufSize) return 0;
+	((const Inner*)p)->serialize(buf);
+	return size;
+}
+
+template<class Inner, class Outer>
+size_t serializePointT(const Outer *p, uint8_t *buf, size_t maxBufSize, size_t size, bls::PointFormat format)
+{
+	if (size > maxBufSize) return 0;
+	((const Inner*)p)->serialize(buf, format);
+	return size;
+}
+
+template<class Inner, class Outer>
+int deserializeT(Outer *p, const uint8_t *buf, size_t bufSize)
+{
+	return ((Inner*)p)->deserialize(buf, bufSize) ? 0 : 1;
+}
+
 void blsInit()
 {
 	bls::init();
 }
 
+void blsSetRandFunc(void *self, size_t (*readFunc)(void *self, void *buf, size_t bufSize))
+{
+	bls::setRandFunc(self, readFunc);
+}
+
 blsId *blsIdCreate()
 {
 	return createT<bls::Id, blsId>();
@@ -76,6 +104,16 @@ size_t blsIdGetStr(const blsId *id, char *buf, size_t maxBufSize)
 	return getStrT<bls::Id, blsId>(id, buf, maxBufSize);
 }
 
+size_t blsIdSerialize(const blsId *id, uint8_t *buf, size_t maxBufSize)
+{
+	return serializeT<bls::Id, blsId>(id, buf, maxBufSize, bls::idSerializedSize);
+}
+
+int blsIdDeserialize(blsId *id, const uint8_t *buf, size_t bufSize)
+{
+	return deserializeT<bls::Id, blsId>(id, buf, bufSize);
+}
+
 void blsIdSet(blsId *id, const uint64_t *p)
 {
 	((bls::Id*)id)->set(p);
@@ -113,6 +151,16 @@ size_t blsSecretKeyGetStr(const blsSecretKey *sec, char *buf, size_t maxBufSize)
 	return getStrT<bls::SecretKey, blsSecretKey>(sec, buf, maxBufSize);
 }
 
+size_t blsSecretKeySerialize(const blsSecretKey *sec, uint8_t *buf, size_t maxBufSize)
+{
+	return serializeT<bls::SecretKey, blsSecretKey>(sec, buf, maxBufSize, bls::secretKeySerializedSize);
+}
+
+int blsSecretKeyDeserialize(blsSecretKey *sec, const uint8_t *buf, size_t bufSize)
+{
+	return deserializeT<bls::SecretKey, blsSecretKey>(sec, buf, bufSize);
+}
+
 void blsSecretKeyInit(blsSecretKey *sec)
 {
 	((bls::SecretKey*)sec)->init();
@@ -128,7 +176,7 @@ void blsSecretKeyGetPublicKey(const blsSecretKey *sec, blsPublicKey *pub)
 }
 void blsSecretKeySign(const blsSecretKey *sec, blsSign *sign, const char *m, size_t size)
 {
-	((const bls::SecretKey*)sec)->sign(*(bls::Sign*)sign, std::string(m, size));
+	((const bls::SecretKey*)sec)->sign(*(bls::Sign*)sign, m, size);
 }
 
 void blsSecretKeySet(blsSecretKey *sec, const blsSecretKey* msk, size_t k, const blsId *id)
@@ -172,10 +220,34 @@ size_t blsPublicKeyGetStr(const blsPublicKey *pub, char *buf, size_t maxBufSize)
 {
 	return getStrT<bls::PublicKey, blsPublicKey>(pub, buf, maxBufSize);
 }
+
+size_t blsPublicKeySerialize(const blsPublicKey *pub, uint8_t *buf, size_t maxBufSize)
+{
+	return serializePointT<bls::PublicKey, blsPublicKey>(pub, buf, maxBufSize, bls::publicKeySerializedSize, bls::PointCompressed);
+}
+
+size_t blsPublicKeySerializeUncompressed(const blsPublicKey *pub, uint8_t *buf, size_t maxBufSize)
+{
+	return serializePointT<bls::PublicKey, blsPublicKey>(pub, buf, maxBufSize, bls::publicKeyUncompressedSize, bls::PointUncompressed);
+}
+
+int blsPublicKeyDeserialize(blsPublicKey *pub, const uint8_t *buf, size_t bufSize)
+{
+	return deserializeT<bls::PublicKey, blsPublicKey>(pub, buf, bufSize);
+}
 void blsPublicKeyAdd(blsPublicKey *pub, const blsPublicKey *rhs)
 {
 	((bls::PublicKey*)pub)->add(*(const bls::PublicKey*)rhs);
 }
+int blsPublicKeyAggregate(blsPublicKey *pub, const blsPublicKey *pubVec, size_t n)
+	try
+{
+	((bls::PublicKey*)pub)->aggregate((const bls::PublicKey*)pubVec, n);
+	return 0;
+} catch (std::exception& e) {
+	fprintf(stderr, "err blsPublicKeyAggregate %s\n", e.what());
+	return -1;
+}
 void blsPublicKeySet(blsPublicKey *pub, const blsPublicKey *mpk, size_t k, const blsId *id)
 {
 	((bls::PublicKey*)pub)->set((const bls::PublicKey*)mpk, k, *(const bls::Id*)id);
@@ -185,6 +257,20 @@ void blsPublicKeyRecover(blsPublicKey *pub, const blsPublicKey *pubVec, const bl
 	((bls::PublicKey*)pub)->recover((const bls::PublicKey*)pubVec, (const bls::Id*)idVec, n);
 }
 
+blsPreparedPublicKey *blsPreparedPublicKeyCreate(const blsPublicKey *pub)
+	try
+{
+	return (blsPreparedPublicKey*)new bls::PreparedPublicKey(*(const bls::PublicKey*)pub);
+} catch (std::exception& e) {
+	fprintf(stderr, "err blsPreparedPublicKeyCreate %s\n", e.what());
+	return NULL;
+}
+
+void blsPreparedPublicKeyDestroy(blsPreparedPublicKey *ppub)
+{
+	delete (bls::PreparedPublicKey*)ppub;
+}
+
 blsSign *blsSignCreate()
 {
 	return createT<bls::Sign, blsSign>();
@@ -211,18 +297,46 @@ size_t blsSignGetStr(const blsSign *sign, char *buf, size_t maxBufSize)
 {
 	return getStrT<bls::Sign, blsSign>(sign, buf, maxBufSize);
 }
+
+size_t blsSignSerialize(const blsSign *sign, uint8_t *buf, size_t maxBufSize)
+{
+	return serializePointT<bls::Sign, blsSign>(sign, buf, maxBufSize, bls::signSerializedSize, bls::PointCompressed);
+}
+
+size_t blsSignSerializeUncompressed(const blsSign *sign, uint8_t *buf, size_t maxBufSize)
+{
+	return serializePointT<bls::Sign, blsSign>(sign, buf, maxBufSize, bls::signUncompressedSize, bls::PointUncompressed);
+}
+
+int blsSignDeserialize(blsSign *sign, const uint8_t *buf, size_t bufSize)
+{
+	return deserializeT<bls::Sign, blsSign>(sign, buf, bufSize);
+}
 void blsSignAdd(blsSign *sign, const blsSign *rhs)
 {
 	((bls::Sign*)sign)->add(*(const bls::Sign*)rhs);
 }
+int blsSignAggregate(blsSign *sign, const blsSign *signVec, size_t n)
+	try
+{
+	((bls::Sign*)sign)->aggregate((const bls::Sign*)signVec, n);
+	return 0;
+} catch (std::exception& e) {
+	fprintf(stderr, "err blsSignAggregate %s\n", e.what());
+	return -1;
+}
 void blsSignRecover(blsSign *sign, const blsSign *signVec, const blsId *idVec, size_t n)
 {
 	((bls::Sign*)sign)->recover((const bls::Sign*)signVec, (const bls::Id*)idVec, n);
 }
+void blsHashToSign(blsSign *sign, const char *m, size_t size)
+{
+	((bls::Sign*)sign)->setHashOf(m, size);
+}
 
 int blsSignVerify(const blsSign *sign, const blsPublicKey *pub, const char *m, size_t size)
 {
-	return ((const bls::Sign*)sign)->verify(*(const bls::PublicKey*)pub, std::string(m, size));
+	return ((const bls::Sign*)sign)->verify(*(const bls::PublicKey*)pub, m, size);
 }
 
 int blsSignVerifyPop(const blsSign *sign, const blsPublicKey *pub)
@@ -230,3 +344,71 @@ int blsSignVerifyPop(const blsSign *sign, const blsPublicKey *pub)
 	return ((const bls::Sign*)sign)->verify(*(const bls::PublicKey*)pub);
 }
 
+
+int blsSignVerifyAggregate(const blsSign *sign, const blsPublicKey *pubVec, const char *const *mVec, const size_t *mSizeVec, size_t n)
+	try
+{
+	return ((const bls::Sign*)sign)->verifyAggregate((const bls::PublicKey*)pubVec, mVec, mSizeVec, n);
+} catch (std::exception& e) {
+	fprintf(stderr, "err blsSignVerifyAggregate %s\n", e.what());
+	return -1;
+}
+
+int blsSignVerifyPrepared(const blsSign *sign, const blsPreparedPublicKey *ppub, const char *m, size_t size)
+	try
+{
+	return ((const bls::Sign*)sign)->verify(*(const bls::PreparedPublicKey*)ppub, m, size);
+} catch (std::exception& e) {
+	fprintf(stderr, "err blsSignVerifyPrepared %s\n", e.what());
+	return -1;
+}
+
+int blsSignVerifyBatch(const blsSign *signVec, const blsPublicKey *pubVec, const char *const *mVec, const size_t *mSizeVec, size_t n, int *resultVec)
+	try
+{
+	std::vector<size_t> badIdxVec;
+	bool ok = bls::verifyBatch((const bls::Sign*)signVec, (const bls::PublicKey*)pubVec, mVec, mSizeVec, n, resultVec ? &badIdxVec : 0);
+	if (resultVec) {
+		for (size_t i = 0; i < n; i++) {
+			resultVec[i] = 1;
+		}
+		for (size_t i = 0; i < badIdxVec.size(); i++) {
+			resultVec[badIdxVec[i]] = 0;
+		}
+	}
+	return ok;
+} catch (std::exception& e) {
+	fprintf(stderr, "err blsSignVerifyBatch %s\n", e.what());
+	return -1;
+}
+
+int blsStatsIsEnabled(void)
+{
+	return bls::isStatsEnabled();
+}
+
+size_t blsStatsGetOpNum(void)
+{
+	return bls::statsOpNum;
+}
+
+const char *blsStatsGetOpName(size_t op)
+{
+	if (op >= bls::statsOpNum) return NULL;
+	return bls::getStatsOpName(bls::StatsOp(op));
+}
+
+size_t blsStatsGet(blsStatsCounter *counterVec, size_t maxN)
+{
+	static_assert(sizeof(blsStatsCounter) == sizeof(bls::StatsCounter), "bad size");
+	bls::StatsCounter tbl[bls::statsOpNum];
+	bls::getStats(tbl);
+	const size_t n = std::min<size_t>(maxN, bls::statsOpNum);
+	memcpy(counterVec, tbl, sizeof(tbl[0]) * n);
+	return n;
+}
+
+void blsStatsReset(void)
+{
+	bls::resetStats();
+}
@@ -0,0 +1,42 @@
+#pragma once
+/**
+	@file
+	@brief precomputed tables of the fixed generator Q and the constants of GLV/GLS
+	the definitions are generated by gen_qtbl.exe at build time
+	@author MITSUNARI Shigeo(@herumi)
+	@license modified new BSD license
+	http://opensource.org/licenses/BSD-3-Clause
+*/
+#include <stdint.h>
+#include <stddef.h>
+
+namespace bls { namespace qtbl {
+
+/*
+	mulTbl[i * (2^windowBit - 1) + j - 1] = j 2^(windowBit i) Q
+	for 0 <= i < windowNum, 1 <= j < 2^windowBit
+	each entry is normalized (z = 1)
+*/
+const size_t windowBit = 4;
+const size_t windowNum = (256 + windowBit - 1) / windowBit;
+
+/*
+	all tables are the raw memory of mcl types
+	fpUnitN is sizeof(Fp) / sizeof(uint64_t) of the generator
+*/
+extern const size_t fpUnitN;
+extern const size_t QcoeffN;
+extern const uint64_t Q[]; // G2
+extern const uint64_t Qcoeff[]; // Fp6[QcoeffN] = precomputeG2(Q)
+extern const uint64_t mulTbl[]; // G2[windowNum * (2^windowBit - 1)]
+
+/*
+	the constants of GLV for G1 and GLS for G2 made by glv::GLV1::init and glv::GLS2::init
+	glv1Int[i] (resp. gls2Int[i]) is the hexadecimal string of GLV1::getInt(i) (resp. GLS2::getInt(i))
+*/
+extern const uint64_t glv1Beta[]; // Fp
+extern const char *const glv1Int[];
+extern const uint64_t gls2G[]; // Fp2[2] = { gx, gy }
+extern const char *const gls2Int[];
+
+} } // bls::qtbl
@@ -0,0 +1,262 @@
+#pragma once
+/**
+	@file
+	@brief buffered random generator by ChaCha20
+	@author MITSUNARI Shigeo(@herumi)
+	@license modified new BSD license
+	http://opensource.org/licenses/BSD-3-Clause
+*/
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <bcrypt.h>
+#include <process.h>
+#pragma comment(lib, "bcrypt.lib")
+#else
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#endif
+
+namespace bls { namespace rand {
+
+inline uint32_t rotl(uint32_t x, int n)
+{
+	return (x << n) | (x >> (32 - n));
+}
+
+inline uint32_t loadU32(const uint8_t *p)
+{
+	return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+inline void storeU32(uint8_t *p, uint32_t x)
+{
+	for (int i = 0; i < 4; i++) {
+		p[i] = uint8_t(x >> (i * 8));
+	}
+}
+
+inline void quarterRound(uint32_t *x, int a, int b, int c, int d)
+{
+	x[a] += x[b]; x[d] = rotl(x[d] ^ x[a], 16);
+	x[c] += x[d]; x[b] = rotl(x[b] ^ x[c], 12);
+	x[a] += x[b]; x[d] = rotl(x[d] ^ x[a], 8);
+	x[c] += x[d]; x[b] = rotl(x[b] ^ x[c], 7);
+}
+
+/*
+	out[0, 64) = the block of ChaCha20 (RFC 7539) for key[8], counter and nonce[3]
+*/
+inline void chacha20Block(uint8_t *out, const uint32_t *key, uint32_t counter, const uint32_t *nonce)
+{
+	uint32_t s[16] = {
+		0x61707865, 0x3320646e, 0x79622d32, 0x6b206574, // "expand 32-byte k"
+		key[0], key[1], key[2], key[3], key[4], key[5], key[6], key[7],
+		counter, nonce[0], nonce[1], nonce[2]
+	};
+	uint32_t x[16];
+	memcpy(x, s, sizeof(x));
+	for (int i = 0; i < 10; i++) {
+		quarterRound(x, 0, 4, 8, 12);
+		quarterRound(x, 1, 5, 9, 13);
+		quarterRound(x, 2, 6, 10, 14);
+		quarterRound(x, 3, 7, 11, 15);
+		quarterRound(x, 0, 5, 10, 15);
+		quarterRound(x, 1, 6, 11, 12);
+		quarterRound(x, 2, 7, 8, 13);
+		quarterRound(x, 3, 4, 9, 14);
+	}
+	for (int i = 0; i < 16; i++) {
+		storeU32(out + i * 4, x[i] + s[i]);
+	}
+}
+
+inline std::atomic<uint32_t>& getForkCounter()
+{
+	static std::atomic<uint32_t> c(0);
+	return c;
+}
+
+inline void incForkCounter()
+{
+	getForkCounter()++;
+}
+
+/*
+	return the number of fork() after the first call in this process
+	the child handler of pthread_atfork increments it, so it needs no system call
+*/
+inline uint32_t getForkGeneration()
+{
+#ifndef _WIN32
+	static const int err = pthread_atfork(0, 0, incForkCounter);
+	(void)err;
+#endif
+	return getForkCounter().load(std::memory_order_relaxed);
+}
+
+/*
+	buf[0, n) = random bytes of the OS
+	it has no buffer and no lock, so the processes made by fork() never get the same bytes
+	and a lock held by another thread at fork() does not block the child
+*/
+inline bool getEntropy(void *buf, size_t n)
+{
+#ifdef _WIN32
+	return BCryptGenRandom(NULL, reinterpret_cast<PUCHAR>(buf), ULONG(n), BCRYPT_USE_SYSTEM_PREFERRED_RNG) == 0;
+#else
+	uint8_t *p = reinterpret_cast<uint8_t*>(buf);
+#ifdef SYS_getrandom
+	while (n > 0) {
+		const long r = syscall(SYS_getrandom, p, n, 0);
+		if (r > 0) {
+			p += r;
+			n -= size_t(r);
+			continue;
+		}
+		if (r < 0 && errno == EINTR) continue;
+		if (r < 0 && errno == ENOSYS) break; // fall back to /dev/urandom
+		return false;
+	}
+	if (n == 0) return true;
+#endif
+	const int fd = open("/dev/urandom", O_RDONLY);
+	if (fd < 0) return false;
+	while (n > 0) {
+		const ssize_t r = ::read(fd, p, n);
+		if (r > 0) {
+			p += r;
+			n -= size_t(r);
+			continue;
+		}
+		if (r < 0 && errno == EINTR) continue;
+		break;
+	}
+	close(fd);
+	return n == 0;
+#endif
+}
+
+inline uint32_t getProcessId()
+{
+#ifdef _WIN32
+	return uint32_t(_getpid());
+#else
+	return uint32_t(getpid());
+#endif
+}
+
+/*
+	random generator by ChaCha20 with fast key erasure
+	it makes blockNum blocks at once and the first 32 bytes of them are the next key
+	so the past output can't be recovered from the state
+	needSeed() is true before the first seed, after reseedInterval bytes and after fork()
+	it is not thread safe ; use an instance for each thread
+*/
+class ChaCha20 {
+	static const size_t blockSize = 64;
+	static const size_t blockNum = 16;
+	static const size_t bufSize = blockSize * blockNum;
+	uint32_t key_[8];
+	uint8_t buf_[bufSize];
+	size_t pos_; // buf_[pos_, bufSize) is not used yet
+	uint64_t outSize_; // bytes from the last seed
+	uint32_t forkGen_;
+	bool seeded_;
+	ChaCha20(const ChaCha20&);
+	void operator=(const ChaCha20&);
+	void refill()
+	{
+		static const uint32_t nonce[3] = {};
+		for (size_t i = 0; i < blockNum; i++) {
+			chacha20Block(buf_ + i * blockSize, key_, uint32_t(i), nonce);
+		}
+		for (size_t i = 0; i < 8; i++) {
+			key_[i] = loadU32(buf_ + i * 4);
+		}
+		memset(buf_, 0, seedSize);
+		pos_ = seedSize;
+	}
+public:
+	static const size_t seedSize = 32;
+	static const uint64_t reseedInterval = uint64_t(1) << 20;
+	ChaCha20()
+		: key_()
+		, pos_(bufSize)
+		, outSize_(0)
+		, forkGen_(0)
+		, seeded_(false)
+	{
+	}
+	~ChaCha20()
+	{
+		volatile uint8_t *p = reinterpret_cast<volatile uint8_t*>(this);
+		for (size_t i = 0; i < sizeof(*this); i++) p[i] = 0;
+	}
+	bool needSeed() const
+	{
+		return !seeded_ || outSize_ >= reseedInterval || forkGen_ != getForkGeneration();
+	}
+	/*
+		mix seed[0, seedSize) into the key
+	*/
+	void reseed(const uint8_t *seed)
+	{
+		for (size_t i = 0; i < 8; i++) {
+			key_[i] ^= loadU32(seed + i * 4);
+		}
+		refill();
+		outSize_ = 0;
+		forkGen_ = getForkGeneration();
+		seeded_ = true;
+	}
+	void read(void *out, size_t n)
+	{
+		uint8_t *p = reinterpret_cast<uint8_t*>(out);
+		outSize_ += n;
+		while (n > 0) {
+			if (pos_ == bufSize) refill();
+			size_t m = bufSize - pos_;
+			if (m > n) m = n;
+			memcpy(p, buf_ + pos_, m);
+			memset(buf_ + pos_, 0, m);
+			pos_ += m;
+			p += m;
+			n -= m;
+		}
+	}
+};
+
+/*
+	buf[0, n) = random bytes by ChaCha20 of each thread which needs no lock
+	the seed is getEntropy() mixed with the process id
+	return false if getEntropy() fails
+*/
+inline bool readRand(void *buf, size_t n)
+{
+	static thread_local ChaCha20 rg;
+	if (rg.needSeed()) {
+		uint8_t seed[ChaCha20::seedSize];
+		if (!getEntropy(seed, sizeof(seed))) return false;
+		const uint32_t pid = getProcessId();
+		uint8_t b[4];
+		storeU32(b, pid);
+		for (size_t i = 0; i < 4; i++) seed[i] ^= b[i];
+		rg.reseed(seed);
+		memset(seed, 0, sizeof(seed));
+	}
+	rg.read(buf, n);
+	return true;
+}
+
+} } // bls::rand
@@ -0,0 +1,99 @@
+/**
+	@file
+	@brief generate the precomputed tables of the fixed generator Q and the constants of GLV/GLS
+	gen_qtbl.exe > bls_qtbl.cpp
+	@author MITSUNARI Shigeo(@herumi)
+	@license modified new BSD license
+	http://opensource.org/licenses/BSD-3-Clause
+*/
+#include "bls_qtbl.hpp"
+#include "bls_glv.hpp"
+#include <mcl/bn256.hpp>
+#include <stdio.h>
+#include <vector>
+
+using namespace mcl::bn256;
+
+template<class T>
+void put(const char *name, const T *x, size_t n)
+{
+	const uint64_t *p = reinterpret_cast<const uint64_t*>(x);
+	const size_t N = sizeof(T) / sizeof(uint64_t) * n;
+	printf("const uint64_t %s[] = {\n", name);
+	for (size_t i = 0; i < N; i++) {
+		printf("%s0x%016llxULL,", (i % 4) == 0 ? "\t" : " ", (unsigned long long)p[i]);
+		if ((i % 4) == 3 || i == N - 1) printf("\n");
+	}
+	printf("};\n");
+}
+
+/*
+	put the integers of a GLV as hexadecimal strings
+*/
+template<class T>
+void putInt(const char *name, const T& glv)
+{
+	printf("const char *const %s[] = {\n", name);
+	for (size_t i = 0; i < T::intN; i++) {
+		printf("\t\"%s\",\n", glv.getInt(i).get_str(16).c_str());
+	}
+	printf("};\n");
+}
+
+int main()
+	try
+{
+	BN::init(mcl::bn::CurveFp254BNb);
+	const G2 Q(
+		Fp2("12723517038133731887338407189719511622662176727675373276651903807414909099441", "4168783608814932154536427934509895782246573715297911553964171371032945126671"),
+		Fp2("13891744915211034074451795021214165905772212241412891944830863846330766296736", "7937318970632701341203597196594272556916396164729705624521405069090520231616")
+	);
+	std::vector<Fp6> Qcoeff;
+	BN::precomputeG2(Qcoeff, Q);
+
+	using namespace bls::qtbl;
+	const size_t m = (size_t(1) << windowBit) - 1;
+	std::vector<G2> tbl(windowNum * m);
+	G2 base = Q;
+	for (size_t i = 0; i < windowNum; i++) {
+		G2 *t = &tbl[i * m];
+		t[0] = base;
+		for (size_t j = 1; j < m; j++) {
+			G2::add(t[j], t[j - 1], base);
+		}
+		for (size_t j = 0; j < windowBit; j++) {
+			G2::dbl(base, base);
+		}
+	}
+	for (size_t i = 0; i < tbl.size(); i++) {
+		tbl[i].normalize();
+	}
+	Fr::init(BN::param.r);
+	bls::glv::GLV1 glv1;
+	{
+		G1 P;
+		mcl::bn::MapTo<Fp> mapTo;
+		mapTo.calcG1(P, Fp(123));
+		glv1.init(BN::param.r, BN::param.p, P);
+	}
+	bls::glv::GLS2 gls2;
+	gls2.init(BN::param.r, BN::param.p, BN::param.z, BN::param.xi, Q);
+	const Fp2 gls2G[] = { gls2.gx, gls2.gy };
+
+	printf("// generated by gen_qtbl.exe. do not edit\n");
+	printf("#include \"bls_qtbl.hpp\"\n\n");
+	printf("namespace bls { namespace qtbl {\n\n");
+	printf("const size_t fpUnitN = %d;\n", (int)(sizeof(Fp) / sizeof(uint64_t)));
+	printf("const size_t QcoeffN = %d;\n", (int)Qcoeff.size());
+	put("Q", &Q, 1);
+	put("Qcoeff", Qcoeff.data(), Qcoeff.size());
+	put("mulTbl", tbl.data(), tbl.size());
+	put("glv1Beta", &glv1.beta, 1);
+	putInt("glv1Int", glv1);
+	put("gls2G", gls2G, 2);
+	putInt("gls2Int", gls2);
+	printf("\n} } // bls::qtbl\n");
+} catch (std::exception& e) {
+	fprintf(stderr, "ERR %s\n", e.what());
+	return 1;
+}
@@ -0,0 +1,113 @@
+#pragma once
+/**
+	@file
+	@brief thread safe LRU cache
+	@author MITSUNARI Shigeo(@herumi)
+	@license modified new BSD license
+	http://opensource.org/licenses/BSD-3-Clause
+*/
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <utility>
+
+namespace bls {
+
+/*
+	map K -> V with at most maxSize entries
+	the least recently used entry is removed if it overflows
+*/
+template<class K, class V>
+class LruCache {
+	typedef std::list<std::pair<K, V> > List;
+	typedef std::unordered_map<K, typename List::iterator> Map;
+	List list_; // the front is the most recently used
+	Map map_;
+	size_t maxSize_;
+	size_t hitNum_;
+	size_t missNum_;
+	mutable std::mutex m_;
+	void shrink()
+	{
+		while (list_.size() > maxSize_) {
+			map_.erase(list_.back().first);
+			list_.pop_back();
+		}
+	}
+public:
+	explicit LruCache(size_t maxSize = 0)
+		: maxSize_(maxSize)
+		, hitNum_(0)
+		, missNum_(0)
+	{
+	}
+	/*
+		return true and set v if k is found
+	*/
+	bool get(V& v, const K& k)
+	{
+		std::lock_guard<std::mutex> lk(m_);
+		typename Map::iterator i = map_.find(k);
+		if (i == map_.end()) {
+			missNum_++;
+			return false;
+		}
+		hitNum_++;
+		list_.splice(list_.begin(), list_, i->second);
+		v = i->second->second;
+		return true;
+	}
+	void put(const K& k, const V& v)
+	{
+		std::lock_guard<std::mutex> lk(m_);
+		if (maxSize_ == 0) return;
+		typename Map::iterator i = map_.find(k);
+		if (i != map_.end()) {
+			i->second->second = v;
+			list_.splice(list_.begin(), list_, i->second);
+			return;
+		}
+		list_.push_front(std::make_pair(k, v));
+		map_[k] = list_.begin();
+		shrink();
+	}
+	void setMaxSize(size_t maxSize)
+	{
+		std::lock_guard<std::mutex> lk(m_);
+		maxSize_ = maxSize;
+		shrink();
+	}
+	size_t getMaxSize() const
+	{
+		std::lock_guard<std::mutex> lk(m_);
+		return maxSize_;
+	}
+	size_t size() const
+	{
+		std::lock_guard<std::mutex> lk(m_);
+		return list_.size();
+	}
+	size_t getHitNum() const
+	{
+		std::lock_guard<std::mutex> lk(m_);
+		return hitNum_;
+	}
+	size_t getMissNum() const
+	{
+		std::lock_guard<std::mutex> lk(m_);
+		return missNum_;
+	}
+	/*
+		remove all entries and reset the counters
+	*/
+	void clear()
+	{
+		std::lock_guard<std::mutex> lk(m_);
+		list_.clear();
+		map_.clear();
+		hitNum_ = 0;
+		missNum_ = 0;
+	}
+};
+
+} // bls
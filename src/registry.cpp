@@ -0,0 +1,154 @@
+/**
+	@file
+	@brief registry of public keys in a file mapped to memory
+	@author MITSUNARI Shigeo(@herumi)
+	@license modified new BSD license
+	http://opensource.org/licenses/BSD-3-Clause
+*/
+#include <bls.hpp>
+#include "lru_cache.hpp"
+#include "thread_pool.hpp"
+#include <cybozu/exception.hpp>
+#include <cybozu/mmap.hpp>
+#include <fstream>
+#include <string.h>
+#include <stdio.h>
+
+namespace bls {
+
+namespace registry {
+
+const char magic[] = "blsPubK1";
+const size_t magicSize = 8;
+const size_t headerSize = magicSize + 8;
+
+inline void writeU64(uint8_t *out, uint64_t x)
+{
+	for (size_t i = 0; i < 8; i++) {
+		out[i] = uint8_t(x >> (i * 8));
+	}
+}
+
+inline uint64_t readU64(const uint8_t *buf)
+{
+	uint64_t x = 0;
+	for (size_t i = 0; i < 8; i++) {
+		x |= uint64_t(buf[i]) << (i * 8);
+	}
+	return x;
+}
+
+} // bls::registry
+
+namespace impl {
+
+struct PublicKeyRegistry {
+	cybozu::Mmap m;
+	const uint8_t *top; // the first key
+	size_t n;
+	DeserializeMode mode;
+	LruCache<size_t, bls::PublicKey> cache;
+	PublicKeyRegistry(const std::string& path, DeserializeMode mode, size_t cacheSize)
+		: m(path)
+		, top(0)
+		, n(0)
+		, mode(mode)
+		, cache(cacheSize)
+	{
+		const uint8_t *p = reinterpret_cast<const uint8_t*>(m.get());
+		const uint64_t size = uint64_t(m.size());
+		if (size < registry::headerSize || memcmp(p, registry::magic, registry::magicSize) != 0) {
+			throw cybozu::Exception("bls:PublicKeyRegistry:bad header") << path;
+		}
+		const uint64_t keyNum = registry::readU64(p + registry::magicSize);
+		if (keyNum != (size - registry::headerSize) / publicKeySerializedSize || (size - registry::headerSize) % publicKeySerializedSize) {
+			throw cybozu::Exception("bls:PublicKeyRegistry:bad size") << path << keyNum << size;
+		}
+		top = p + registry::headerSize;
+		n = size_t(keyNum);
+	}
+};
+
+} // bls::impl
+
+PublicKeyRegistry::PublicKeyRegistry(const std::string& path, DeserializeMode mode, size_t cacheSize)
+	: self_(new impl::PublicKeyRegistry(path, mode, cacheSize))
+{
+}
+
+PublicKeyRegistry::~PublicKeyRegistry()
+{
+	delete self_;
+}
+
+size_t PublicKeyRegistry::size() const
+{
+	return self_->n;
+}
+
+void PublicKeyRegistry::get(PublicKey& pub, size_t idx) const
+{
+	if (idx >= self_->n) throw cybozu::Exception("bls:PublicKeyRegistry:get:bad idx") << idx << self_->n;
+	if (self_->cache.get(pub, idx)) return;
+	if (!pub.deserialize(self_->top + idx * publicKeySerializedSize, publicKeySerializedSize, self_->mode)) {
+		throw cybozu::Exception("bls:PublicKeyRegistry:get:bad key") << idx;
+	}
+	self_->cache.put(idx, pub);
+}
+
+void PublicKeyRegistry::build(const std::string& path, const PublicKey *pubVec, size_t n, ThreadPool *pool)
+{
+	std::vector<uint8_t> buf(registry::headerSize + n * publicKeySerializedSize);
+	memcpy(&buf[0], registry::magic, registry::magicSize);
+	registry::writeU64(&buf[registry::magicSize], n);
+	uint8_t *top = &buf[registry::headerSize];
+	parallelFor(pool, n, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			uint8_t *p = top + i * publicKeySerializedSize;
+			pubVec[i].serialize(p);
+			PublicKey pub;
+			if (!pub.deserialize(p, publicKeySerializedSize, DeserializeChecked)) {
+				throw cybozu::Exception("bls:PublicKeyRegistry:build:bad key") << i;
+			}
+		}
+	});
+	/*
+		write to a temporary file and rename it to path
+		so that path is not left truncated if the write fails
+	*/
+	const std::string tmpPath = path + ".tmp";
+	{
+		std::ofstream ofs(tmpPath.c_str(), std::ios::binary);
+		ofs.write(reinterpret_cast<const char*>(&buf[0]), buf.size());
+		ofs.close();
+		if (!ofs) {
+			remove(tmpPath.c_str());
+			throw cybozu::Exception("bls:PublicKeyRegistry:build:can't write") << tmpPath;
+		}
+	}
+#ifdef _WIN32
+	// rename() of Windows does not replace an existing file
+	remove(path.c_str());
+#endif
+	if (rename(tmpPath.c_str(), path.c_str()) != 0) {
+		remove(tmpPath.c_str());
+		throw cybozu::Exception("bls:PublicKeyRegistry:build:can't rename") << tmpPath << path;
+	}
+}
+
+void PublicKeyRegistry::convertFromText(const std::string& path, const std::string& textPath, ThreadPool *pool)
+{
+	std::ifstream ifs(textPath.c_str());
+	if (!ifs) throw cybozu::Exception("bls:PublicKeyRegistry:convertFromText:can't open") << textPath;
+	PublicKeyVec pubVec;
+	for (;;) {
+		ifs >> std::ws;
+		if (ifs.eof()) break;
+		PublicKey pub;
+		if (!(ifs >> pub)) throw cybozu::Exception("bls:PublicKeyRegistry:convertFromText:bad text") << textPath << pubVec.size();
+		pubVec.push_back(pub);
+	}
+	build(path, pubVec.data(), pubVec.size(), pool);
+}
+
+} // bls
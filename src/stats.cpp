@@ -0,0 +1,117 @@
+/**
+	@file
+	@brief counters and latency histograms of the hot paths
+	@author MITSUNARI Shigeo(@herumi)
+	@license modified new BSD license
+	http://opensource.org/licenses/BSD-3-Clause
+*/
+#include "stats.hpp"
+#include <cybozu/exception.hpp>
+#include <string.h>
+#ifdef BLS_ENABLE_STATS
+#include <atomic>
+#endif
+
+namespace bls {
+
+#ifdef BLS_ENABLE_STATS
+namespace stats {
+
+struct Counter {
+	std::atomic<uint64_t> count;
+	std::atomic<uint64_t> totalNsec;
+	std::atomic<uint64_t> histogram[statsHistogramSize];
+};
+
+/*
+	zero initialized as a static object
+*/
+static Counter counterTbl[statsOpNum];
+
+/*
+	floor(log2(nsec)) for nsec > 0
+*/
+static size_t getHistogramIdx(uint64_t nsec)
+{
+	size_t i = 0;
+	while (nsec > 1 && i < statsHistogramSize - 1) {
+		nsec >>= 1;
+		i++;
+	}
+	return i;
+}
+
+void record(StatsOp op, uint64_t nsec)
+{
+	Counter& c = counterTbl[op];
+	c.count.fetch_add(1, std::memory_order_relaxed);
+	c.totalNsec.fetch_add(nsec, std::memory_order_relaxed);
+	c.histogram[getHistogramIdx(nsec)].fetch_add(1, std::memory_order_relaxed);
+}
+
+} // bls::stats
+#endif
+
+bool isStatsEnabled()
+{
+#ifdef BLS_ENABLE_STATS
+	return true;
+#else
+	return false;
+#endif
+}
+
+const char *getStatsOpName(StatsOp op)
+{
+	static const char *tbl[] = {
+		"MillerLoop",
+		"FinalExp",
+		"G1Mul",
+		"G2Mul",
+		"MulVec",
+		"HashToG1",
+		"MapToG1",
+		"Serialize",
+		"Deserialize",
+		"GetStr",
+		"SetStr",
+		"LagrangeInv",
+		"Normalize",
+	};
+	static_assert(sizeof(tbl) / sizeof(tbl[0]) == statsOpNum, "bad tbl");
+	if (size_t(op) >= statsOpNum) throw cybozu::Exception("bls:getStatsOpName:bad op") << int(op);
+	return tbl[op];
+}
+
+void getStats(StatsCounter *counterVec)
+{
+#ifdef BLS_ENABLE_STATS
+	for (size_t i = 0; i < statsOpNum; i++) {
+		const stats::Counter& c = stats::counterTbl[i];
+		StatsCounter& out = counterVec[i];
+		out.count = c.count.load(std::memory_order_relaxed);
+		out.totalNsec = c.totalNsec.load(std::memory_order_relaxed);
+		for (size_t j = 0; j < statsHistogramSize; j++) {
+			out.histogram[j] = c.histogram[j].load(std::memory_order_relaxed);
+		}
+	}
+#else
+	memset(counterVec, 0, sizeof(StatsCounter) * statsOpNum);
+#endif
+}
+
+void resetStats()
+{
+#ifdef BLS_ENABLE_STATS
+	for (size_t i = 0; i < statsOpNum; i++) {
+		stats::Counter& c = stats::counterTbl[i];
+		c.count.store(0, std::memory_order_relaxed);
+		c.totalNsec.store(0, std::memory_order_relaxed);
+		for (size_t j = 0; j < statsHistogramSize; j++) {
+			c.histogram[j].store(0, std::memory_order_relaxed);
+		}
+	}
+#endif
+}
+
+} // bls
@@ -0,0 +1,46 @@
+#pragma once
+/**
+	@file
+	@brief counters and latency histograms of the hot paths
+	@author MITSUNARI Shigeo(@herumi)
+	@license modified new BSD license
+	http://opensource.org/licenses/BSD-3-Clause
+*/
+#include <bls.hpp>
+
+#ifdef BLS_ENABLE_STATS
+
+#include <chrono>
+
+namespace bls { namespace stats {
+
+void record(StatsOp op, uint64_t nsec);
+
+/*
+	record the time from the constructor to the destructor
+*/
+class Scope {
+	typedef std::chrono::steady_clock Clock;
+	StatsOp op_;
+	Clock::time_point begin_;
+	Scope(const Scope&);
+	void operator=(const Scope&);
+public:
+	explicit Scope(StatsOp op) : op_(op), begin_(Clock::now()) {}
+	~Scope()
+	{
+		record(op_, uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin_).count()));
+	}
+};
+
+} } // bls::stats
+
+#define BLS_STATS_CONCAT2(a, b) a ## b
+#define BLS_STATS_CONCAT(a, b) BLS_STATS_CONCAT2(a, b)
+#define BLS_STATS_SCOPE(op) bls::stats::Scope BLS_STATS_CONCAT(blsStatsScope, __LINE__)(op)
+
+#else
+
+#define BLS_STATS_SCOPE(op)
+
+#endif
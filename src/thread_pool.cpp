@@ -0,0 +1,214 @@
+/**
+	@file
+	@brief thread pool with work stealing
+	@author MITSUNARI Shigeo(@herumi)
+	@license modified new BSD license
+	http://opensource.org/licenses/BSD-3-Clause
+*/
+#include <bls.hpp>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <exception>
+#include <algorithm>
+
+namespace bls {
+
+namespace impl {
+
+/*
+	queues[i] is the task queue of the i-th worker
+	queues[threadNum - 1] is used by the thread calling run()
+	a worker pops a task from the back of its own queue
+	and steals one from the front of the other queues if it is empty
+	run() called by a task of the same pool calls f on the thread
+	because runM is held by the outer run() and the workers may be busy
+*/
+struct ThreadPool {
+	struct Task {
+		size_t begin;
+		size_t end;
+	};
+	struct Queue {
+		std::mutex m;
+		std::deque<Task> q;
+	};
+	typedef std::function<void(size_t, size_t)> Func;
+	std::vector<std::thread> threads;
+	std::vector<std::unique_ptr<Queue> > queues;
+	std::mutex runM; // serialize run()
+	std::mutex m;
+	std::condition_variable startCv;
+	std::condition_variable doneCv;
+	size_t generation;
+	bool quit;
+	const Func *f;
+	std::atomic<size_t> remain;
+	std::exception_ptr err;
+
+	explicit ThreadPool(size_t threadNum)
+		: generation(0)
+		, quit(false)
+		, f(0)
+		, remain(0)
+	{
+		if (threadNum == 0) threadNum = std::thread::hardware_concurrency();
+		if (threadNum == 0) threadNum = 1;
+		queues.resize(threadNum);
+		for (size_t i = 0; i < threadNum; i++) {
+			queues[i].reset(new Queue());
+		}
+		for (size_t i = 0; i + 1 < threadNum; i++) {
+			threads.push_back(std::thread(&ThreadPool::worker, this, i));
+		}
+	}
+	~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lk(m);
+			quit = true;
+		}
+		startCv.notify_all();
+		for (size_t i = 0; i < threads.size(); i++) {
+			threads[i].join();
+		}
+	}
+	/*
+		the pool whose task the current thread runs
+	*/
+	static const ThreadPool*& getCurrent()
+	{
+		static thread_local const ThreadPool *p = 0;
+		return p;
+	}
+	struct CurrentScope {
+		const ThreadPool *prev;
+		explicit CurrentScope(const ThreadPool *p) : prev(getCurrent()) { getCurrent() = p; }
+		~CurrentScope() { getCurrent() = prev; }
+	};
+	bool pop(Task& t, size_t idx)
+	{
+		Queue& own = *queues[idx];
+		{
+			std::lock_guard<std::mutex> lk(own.m);
+			if (!own.q.empty()) {
+				t = own.q.back();
+				own.q.pop_back();
+				return true;
+			}
+		}
+		const size_t n = queues.size();
+		for (size_t i = 1; i < n; i++) {
+			Queue& other = *queues[(idx + i) % n];
+			std::lock_guard<std::mutex> lk(other.m);
+			if (!other.q.empty()) {
+				t = other.q.front();
+				other.q.pop_front();
+				return true;
+			}
+		}
+		return false;
+	}
+	void exec(size_t idx)
+	{
+		Task t;
+		while (pop(t, idx)) {
+			try {
+				(*f)(t.begin, t.end);
+			} catch (...) {
+				std::lock_guard<std::mutex> lk(m);
+				if (!err) err = std::current_exception();
+			}
+			if (--remain == 0) {
+				std::lock_guard<std::mutex> lk(m);
+				doneCv.notify_all();
+			}
+		}
+	}
+	void worker(size_t idx)
+	{
+		getCurrent() = this;
+		size_t seen = 0;
+		for (;;) {
+			{
+				std::unique_lock<std::mutex> lk(m);
+				startCv.wait(lk, [&] { return quit || generation != seen; });
+				if (quit) return;
+				seen = generation;
+			}
+			exec(idx);
+		}
+	}
+	void run(size_t n, const Func& func, size_t grainSize)
+	{
+		if (n == 0) return;
+		if (grainSize == 0) grainSize = 1;
+		if (getCurrent() == this) {
+			for (size_t begin = 0; begin < n; begin += grainSize) {
+				func(begin, std::min(begin + grainSize, n));
+			}
+			return;
+		}
+		std::lock_guard<std::mutex> runLk(runM);
+		CurrentScope scope(this);
+		const size_t threadNum = queues.size();
+		const size_t taskNum = (n + grainSize - 1) / grainSize;
+		f = &func;
+		err = nullptr;
+		remain = taskNum;
+		/*
+			give each queue a contiguous range of tasks
+		*/
+		for (size_t i = 0; i < threadNum; i++) {
+			const size_t tb = taskNum * i / threadNum;
+			const size_t te = taskNum * (i + 1) / threadNum;
+			Queue& q = *queues[i];
+			std::lock_guard<std::mutex> lk(q.m);
+			for (size_t j = tb; j < te; j++) {
+				Task t;
+				t.begin = j * grainSize;
+				t.end = std::min(t.begin + grainSize, n);
+				q.q.push_back(t);
+			}
+		}
+		{
+			std::lock_guard<std::mutex> lk(m);
+			generation++;
+		}
+		startCv.notify_all();
+		exec(threadNum - 1);
+		{
+			std::unique_lock<std::mutex> lk(m);
+			doneCv.wait(lk, [&] { return remain == 0; });
+		}
+		f = 0;
+		if (err) std::rethrow_exception(err);
+	}
+};
+
+} // bls::impl
+
+ThreadPool::ThreadPool(size_t threadNum)
+	: self_(new impl::ThreadPool(threadNum))
+{
+}
+
+ThreadPool::~ThreadPool()
+{
+	delete self_;
+}
+
+size_t ThreadPool::getThreadNum() const
+{
+	return self_->queues.size();
+}
+
+void ThreadPool::run(size_t n, const std::function<void(size_t, size_t)>& f, size_t grainSize)
+{
+	self_->run(n, f, grainSize);
+}
+
+} // bls
@@ -0,0 +1,32 @@
+#pragma once
+/**
+	@file
+	@brief parallel loop on ThreadPool
+	@author MITSUNARI Shigeo(@herumi)
+	@license modified new BSD license
+	http://opensource.org/licenses/BSD-3-Clause
+*/
+#include <bls.hpp>
+
+namespace bls {
+
+/*
+	call f(begin, end) for the ranges of [0, n)
+	in parallel if pool is not NULL
+	grainSize = 0 makes a few tasks per thread to balance the load
+*/
+template<class F>
+void parallelFor(ThreadPool *pool, size_t n, const F& f, size_t grainSize = 0)
+{
+	if (n == 0) return;
+	if (pool == 0 || pool->getThreadNum() == 1 || n == 1) {
+		f(0, n);
+		return;
+	}
+	if (grainSize == 0) {
+		grainSize = (n + pool->getThreadNum() * 4 - 1) / (pool->getThreadNum() * 4);
+	}
+	pool->run(n, f, grainSize);
+}
+
+} // bls
@@ -1,6 +1,44 @@
 #include <cybozu/test.hpp>
 #include <bls_if.h>
 #include <string.h>
+#include <stdlib.h>
+#include <new>
+#include <gmp.h>
+
+/*
+	count the allocations by operator new and by GMP (mpz_class)
+*/
+static size_t allocCount = 0;
+
+void *operator new(size_t n)
+{
+	allocCount++;
+	void *p = malloc(n ? n : 1);
+	if (p == 0) throw std::bad_alloc();
+	return p;
+}
+
+void operator delete(void *p) noexcept
+{
+	free(p);
+}
+
+static void *gmpAlloc(size_t n)
+{
+	allocCount++;
+	return malloc(n);
+}
+
+static void *gmpRealloc(void *p, size_t, size_t n)
+{
+	allocCount++;
+	return realloc(p, n);
+}
+
+static void gmpFree(void *p, size_t)
+{
+	free(p);
+}
 
 CYBOZU_TEST_AUTO(bls_if)
 {
@@ -49,4 +87,168 @@ CYBOZU_TEST_AUTO(bls_if_use_stack)
 	blsSignPut(&sign);
 
 	printf("verify %d\n", blsSignVerify(&sign, &pub, msg, msgSize));
+
+	blsPreparedPublicKey *ppub = blsPreparedPublicKeyCreate(&pub);
+	CYBOZU_TEST_ASSERT(ppub != NULL);
+	CYBOZU_TEST_EQUAL(blsSignVerifyPrepared(&sign, ppub, msg, msgSize), 1);
+	CYBOZU_TEST_EQUAL(blsSignVerifyPrepared(&sign, ppub, msg, msgSize - 1), 0);
+	blsPreparedPublicKeyDestroy(ppub);
+}
+
+CYBOZU_TEST_AUTO(bls_if_verifyBatch)
+{
+	const size_t n = 3;
+	blsSecretKey sec;
+	blsPublicKey pubVec[n];
+	blsSign signVec[n];
+	const char *mVec[n] = { "abc", "this is a pen", "xyz" };
+	size_t mSizeVec[n];
+	int resultVec[n];
+
+	blsInit();
+	for (size_t i = 0; i < n; i++) {
+		mSizeVec[i] = strlen(mVec[i]);
+		blsSecretKeyInit(&sec);
+		blsSecretKeyGetPublicKey(&sec, &pubVec[i]);
+		blsSecretKeySign(&sec, &signVec[i], mVec[i], mSizeVec[i]);
+	}
+	CYBOZU_TEST_EQUAL(blsSignVerifyBatch(signVec, pubVec, mVec, mSizeVec, n, resultVec), 1);
+	for (size_t i = 0; i < n; i++) {
+		CYBOZU_TEST_EQUAL(resultVec[i], 1);
+	}
+	mSizeVec[1]--;
+	CYBOZU_TEST_EQUAL(blsSignVerifyBatch(signVec, pubVec, mVec, mSizeVec, n, resultVec), 0);
+	CYBOZU_TEST_EQUAL(resultVec[0], 1);
+	CYBOZU_TEST_EQUAL(resultVec[1], 0);
+	CYBOZU_TEST_EQUAL(resultVec[2], 1);
+}
+
+CYBOZU_TEST_AUTO(bls_if_serialize)
+{
+	blsId id;
+	blsSecretKey sec, sec2;
+	blsPublicKey pub, pub2;
+	blsSign sign, sign2;
+	uint8_t buf[BLS_PUBLICKEY_SERIALIZED_SIZE];
+	const char *msg = "this is a pen";
+	const size_t msgSize = strlen(msg);
+
+	blsInit();
+	const uint64_t v[] = { 1, 2, 3, 4 };
+	blsIdSet(&id, v);
+	CYBOZU_TEST_EQUAL(blsIdSerialize(&id, buf, BLS_ID_SERIALIZED_SIZE - 1), 0);
+	CYBOZU_TEST_EQUAL(blsIdSerialize(&id, buf, sizeof(buf)), BLS_ID_SERIALIZED_SIZE);
+	CYBOZU_TEST_EQUAL(blsIdDeserialize(&id, buf, BLS_ID_SERIALIZED_SIZE), 0);
+
+	blsSecretKeyInit(&sec);
+	CYBOZU_TEST_EQUAL(blsSecretKeySerialize(&sec, buf, sizeof(buf)), BLS_SECRETKEY_SERIALIZED_SIZE);
+	CYBOZU_TEST_EQUAL(blsSecretKeyDeserialize(&sec2, buf, BLS_SECRETKEY_SERIALIZED_SIZE), 0);
+	CYBOZU_TEST_EQUAL(memcmp(&sec, &sec2, sizeof(sec)), 0);
+	CYBOZU_TEST_EQUAL(blsSecretKeyDeserialize(&sec2, buf, BLS_SECRETKEY_SERIALIZED_SIZE - 1), 1);
+
+	blsSecretKeyGetPublicKey(&sec, &pub);
+	CYBOZU_TEST_EQUAL(blsPublicKeySerialize(&pub, buf, sizeof(buf)), BLS_PUBLICKEY_SERIALIZED_SIZE);
+	CYBOZU_TEST_EQUAL(blsPublicKeyDeserialize(&pub2, buf, BLS_PUBLICKEY_SERIALIZED_SIZE), 0);
+
+	blsSecretKeySign(&sec, &sign, msg, msgSize);
+	CYBOZU_TEST_EQUAL(blsSignSerialize(&sign, buf, sizeof(buf)), BLS_SIGN_SERIALIZED_SIZE);
+	CYBOZU_TEST_EQUAL(blsSignDeserialize(&sign2, buf, BLS_SIGN_SERIALIZED_SIZE), 0);
+	CYBOZU_TEST_EQUAL(blsSignVerify(&sign2, &pub2, msg, msgSize), 1);
+	{
+		uint8_t ubuf[BLS_PUBLICKEY_UNCOMPRESSED_SIZE];
+		CYBOZU_TEST_EQUAL(blsPublicKeySerializeUncompressed(&pub, ubuf, BLS_PUBLICKEY_SERIALIZED_SIZE), 0);
+		CYBOZU_TEST_EQUAL(blsPublicKeySerializeUncompressed(&pub, ubuf, sizeof(ubuf)), BLS_PUBLICKEY_UNCOMPRESSED_SIZE);
+		CYBOZU_TEST_EQUAL(blsPublicKeyDeserialize(&pub2, ubuf, BLS_PUBLICKEY_UNCOMPRESSED_SIZE), 0);
+		CYBOZU_TEST_EQUAL(blsSignSerializeUncompressed(&sign, ubuf, sizeof(ubuf)), BLS_SIGN_UNCOMPRESSED_SIZE);
+		CYBOZU_TEST_EQUAL(blsSignDeserialize(&sign2, ubuf, BLS_SIGN_UNCOMPRESSED_SIZE), 0);
+		CYBOZU_TEST_EQUAL(blsSignVerify(&sign2, &pub2, msg, msgSize), 1);
+	}
+	buf[0] ^= 1;
+	if (blsSignDeserialize(&sign2, buf, BLS_SIGN_SERIALIZED_SIZE) == 0) {
+		CYBOZU_TEST_EQUAL(blsSignVerify(&sign2, &pub2, msg, msgSize), 0);
+	}
+}
+
+CYBOZU_TEST_AUTO(bls_if_serialize_noalloc)
+{
+	blsId id;
+	blsSecretKey sec;
+	blsPublicKey pub;
+	blsSign sign;
+	uint8_t buf[BLS_PUBLICKEY_UNCOMPRESSED_SIZE];
+	mp_set_memory_functions(gmpAlloc, gmpRealloc, gmpFree);
+	blsInit();
+	const uint64_t v[] = { 1, 2, 3, 4 };
+	blsIdSet(&id, v);
+	blsSecretKeyInit(&sec);
+	blsSecretKeyGetPublicKey(&sec, &pub);
+	blsSecretKeySign(&sec, &sign, "abc", 3);
+	const size_t c = allocCount;
+	CYBOZU_TEST_EQUAL(blsIdSerialize(&id, buf, sizeof(buf)), BLS_ID_SERIALIZED_SIZE);
+	CYBOZU_TEST_EQUAL(blsIdDeserialize(&id, buf, BLS_ID_SERIALIZED_SIZE), 0);
+	CYBOZU_TEST_EQUAL(blsSecretKeySerialize(&sec, buf, sizeof(buf)), BLS_SECRETKEY_SERIALIZED_SIZE);
+	CYBOZU_TEST_EQUAL(blsSecretKeyDeserialize(&sec, buf, BLS_SECRETKEY_SERIALIZED_SIZE), 0);
+	CYBOZU_TEST_EQUAL(blsPublicKeySerialize(&pub, buf, sizeof(buf)), BLS_PUBLICKEY_SERIALIZED_SIZE);
+	CYBOZU_TEST_EQUAL(blsPublicKeyDeserialize(&pub, buf, BLS_PUBLICKEY_SERIALIZED_SIZE), 0);
+	CYBOZU_TEST_EQUAL(blsPublicKeySerializeUncompressed(&pub, buf, sizeof(buf)), BLS_PUBLICKEY_UNCOMPRESSED_SIZE);
+	CYBOZU_TEST_EQUAL(blsPublicKeyDeserialize(&pub, buf, BLS_PUBLICKEY_UNCOMPRESSED_SIZE), 0);
+	CYBOZU_TEST_EQUAL(blsSignSerialize(&sign, buf, sizeof(buf)), BLS_SIGN_SERIALIZED_SIZE);
+	CYBOZU_TEST_EQUAL(blsSignDeserialize(&sign, buf, BLS_SIGN_SERIALIZED_SIZE), 0);
+	CYBOZU_TEST_EQUAL(blsSignSerializeUncompressed(&sign, buf, sizeof(buf)), BLS_SIGN_UNCOMPRESSED_SIZE);
+	CYBOZU_TEST_EQUAL(blsSignDeserialize(&sign, buf, BLS_SIGN_UNCOMPRESSED_SIZE), 0);
+	CYBOZU_TEST_EQUAL(allocCount, c);
+}
+
+CYBOZU_TEST_AUTO(bls_if_aggregate)
+{
+	const size_t n = 5;
+	blsSecretKey sec;
+	blsPublicKey pubVec[n], pub, sumPub;
+	blsSign signVec[n], sign, sumSign;
+	const char *msg = "this is a pen";
+	const size_t msgSize = strlen(msg);
+	char buf1[1024], buf2[1024];
+
+	blsInit();
+	for (size_t i = 0; i < n; i++) {
+		blsSecretKeyInit(&sec);
+		blsSecretKeyGetPublicKey(&sec, &pubVec[i]);
+		blsSecretKeySign(&sec, &signVec[i], msg, msgSize);
+		if (i == 0) {
+			sumPub = pubVec[0];
+			sumSign = signVec[0];
+		} else {
+			blsPublicKeyAdd(&sumPub, &pubVec[i]);
+			blsSignAdd(&sumSign, &signVec[i]);
+		}
+	}
+	CYBOZU_TEST_EQUAL(blsPublicKeyAggregate(&pub, pubVec, n), 0);
+	CYBOZU_TEST_EQUAL(blsSignAggregate(&sign, signVec, n), 0);
+	size_t size = blsPublicKeyGetStr(&pub, buf1, sizeof(buf1));
+	CYBOZU_TEST_EQUAL(blsPublicKeyGetStr(&sumPub, buf2, sizeof(buf2)), size);
+	CYBOZU_TEST_EQUAL(memcmp(buf1, buf2, size), 0);
+	size = blsSignGetStr(&sign, buf1, sizeof(buf1));
+	CYBOZU_TEST_EQUAL(blsSignGetStr(&sumSign, buf2, sizeof(buf2)), size);
+	CYBOZU_TEST_EQUAL(memcmp(buf1, buf2, size), 0);
+	CYBOZU_TEST_EQUAL(blsSignVerify(&sign, &pub, msg, msgSize), 1);
+}
+
+CYBOZU_TEST_AUTO(bls_if_stats)
+{
+	blsStatsCounter c[32];
+	const size_t n = blsStatsGetOpNum();
+	CYBOZU_TEST_ASSERT(n <= 32);
+	CYBOZU_TEST_EQUAL(blsStatsGetOpName(n), (const char*)0);
+	blsStatsReset();
+	blsSecretKey sec;
+	blsSign sign;
+	blsSecretKeyInit(&sec);
+	blsSecretKeySign(&sec, &sign, "abc", 3);
+	CYBOZU_TEST_EQUAL(blsStatsGet(c, 1), 1);
+	CYBOZU_TEST_EQUAL(blsStatsGet(c, 32), n);
+	for (size_t i = 0; i < n; i++) {
+		if (strcmp(blsStatsGetOpName(i), "G1Mul") == 0) {
+			CYBOZU_TEST_EQUAL(c[i].count, blsStatsIsEnabled() ? 1u : 0u);
+		}
+	}
 }
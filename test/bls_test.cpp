@@ -1,8 +1,13 @@
 #include <bls.hpp>
+#include <mcl/bn256.hpp>
 #include <cybozu/test.hpp>
 #include <cybozu/inttype.hpp>
 #include <iostream>
 #include <sstream>
+#include <fstream>
+#include <string.h>
+#include <thread>
+#include <algorithm>
 
 template<class T>
 void streamTest(const T& t)
@@ -15,15 +20,29 @@ void streamTest(const T& t)
 	CYBOZU_TEST_EQUAL(t, t2);
 }
 
+template<class T>
+void serializeTest(const T& t, size_t size)
+{
+	uint8_t buf[128];
+	t.serialize(buf);
+	T t2;
+	CYBOZU_TEST_ASSERT(t2.deserialize(buf, size));
+	CYBOZU_TEST_EQUAL(t, t2);
+	CYBOZU_TEST_ASSERT(!t2.deserialize(buf, size - 1));
+	CYBOZU_TEST_ASSERT(!t2.deserialize(buf, size + 1));
+}
+
 CYBOZU_TEST_AUTO(bls)
 {
 	bls::init();
 	bls::SecretKey sec;
 	sec.init();
 	streamTest(sec);
+	serializeTest(sec, bls::secretKeySerializedSize);
 	bls::PublicKey pub;
 	sec.getPublicKey(pub);
 	streamTest(pub);
+	serializeTest(pub, bls::publicKeySerializedSize);
 	for (int i = 0; i < 5; i++) {
 		std::string m = "hello";
 		m += char('0' + i);
@@ -32,7 +51,187 @@ CYBOZU_TEST_AUTO(bls)
 		CYBOZU_TEST_ASSERT(s.verify(pub, m));
 		CYBOZU_TEST_ASSERT(!s.verify(pub, m + "a"));
 		streamTest(s);
+		serializeTest(s, bls::signSerializedSize);
+	}
+}
+
+CYBOZU_TEST_AUTO(serialize)
+{
+	{
+		bls::Id id;
+		const uint64_t v[] = { 1, 2, 3, 4 };
+		id.set(v);
+		serializeTest(id, bls::idSerializedSize);
+		uint8_t buf[bls::idSerializedSize];
+		id.serialize(buf);
+		CYBOZU_TEST_EQUAL(buf[0], 1);
+		CYBOZU_TEST_EQUAL(buf[8], 2);
+		CYBOZU_TEST_EQUAL(buf[31], 0);
+		// not less than r
+		memset(buf, 0xff, sizeof(buf));
+		CYBOZU_TEST_ASSERT(!id.deserialize(buf, sizeof(buf)));
+	}
+	bls::SecretKey sec;
+	sec.init();
+	bls::PublicKey pub;
+	sec.getPublicKey(pub);
+	bls::Sign s;
+	sec.sign(s, "abc");
+	// the point at infinity
+	{
+		bls::PublicKey zeroPub;
+		bls::Sign zeroSign;
+		serializeTest(zeroPub, bls::publicKeySerializedSize);
+		serializeTest(zeroSign, bls::signSerializedSize);
+		uint8_t buf[bls::signSerializedSize];
+		zeroSign.serialize(buf);
+		CYBOZU_TEST_EQUAL(buf[bls::signSerializedSize - 1], 0x40);
+		buf[0] = 1;
+		CYBOZU_TEST_ASSERT(!zeroSign.deserialize(buf, sizeof(buf)));
+	}
+	// the flag of the sign of y gives -P
+	{
+		uint8_t buf[bls::signSerializedSize];
+		s.serialize(buf);
+		buf[bls::signSerializedSize - 1] ^= 0x80;
+		bls::Sign s2;
+		CYBOZU_TEST_ASSERT(s2.deserialize(buf, sizeof(buf)));
+		s2.add(s);
+		CYBOZU_TEST_EQUAL(s2, bls::Sign());
+	}
+	// x >= p
+	{
+		uint8_t buf[bls::publicKeySerializedSize];
+		memset(buf, 0xff, sizeof(buf));
+		buf[sizeof(buf) - 1] = 0x3f;
+		bls::PublicKey pub2;
+		CYBOZU_TEST_ASSERT(!pub2.deserialize(buf, sizeof(buf)));
+	}
+	/*
+		about half of x has no y on the curve
+		and the points on the twist curve are not in G2 except for a negligible probability
+	*/
+	{
+		uint8_t buf[bls::publicKeySerializedSize];
+		pub.serialize(buf);
+		int okNum = 0;
+		for (int i = 0; i < 20; i++) {
+			buf[0]++;
+			bls::PublicKey pub2;
+			if (pub2.deserialize(buf, sizeof(buf))) okNum++;
+		}
+		CYBOZU_TEST_EQUAL(okNum, 0);
+	}
+	// uncompressed
+	{
+		uint8_t buf[bls::publicKeyUncompressedSize];
+		bls::PublicKey pub2;
+		pub.serialize(buf, bls::PointUncompressed);
+		CYBOZU_TEST_ASSERT(pub2.deserialize(buf, sizeof(buf)));
+		CYBOZU_TEST_EQUAL(pub2, pub);
+		CYBOZU_TEST_ASSERT(!pub2.deserialize(buf, bls::publicKeySerializedSize));
+		bls::PublicKey().serialize(buf, bls::PointUncompressed);
+		CYBOZU_TEST_ASSERT(pub2.deserialize(buf, sizeof(buf)));
+		CYBOZU_TEST_EQUAL(pub2, bls::PublicKey());
+		uint8_t sbuf[bls::signUncompressedSize];
+		bls::Sign s2;
+		s.serialize(sbuf, bls::PointUncompressed);
+		CYBOZU_TEST_ASSERT(s2.deserialize(sbuf, sizeof(sbuf)));
+		CYBOZU_TEST_EQUAL(s2, s);
+		CYBOZU_TEST_ASSERT(!s2.deserialize(sbuf, bls::signSerializedSize));
+		// not on the curve
+		sbuf[bls::signSerializedSize]++;
+		CYBOZU_TEST_ASSERT(!s2.deserialize(sbuf, sizeof(sbuf)));
+		pub.serialize(buf, bls::PointUncompressed);
+		buf[bls::publicKeySerializedSize]++;
+		CYBOZU_TEST_ASSERT(!pub2.deserialize(buf, sizeof(buf)));
+	}
+}
+
+/*
+	reload n public keys serialized in buf
+*/
+static bool loadPublicKeyVec(bls::PublicKeyVec& pubVec, const std::vector<uint8_t>& buf, bls::DeserializeMode mode)
+{
+	const size_t n = buf.size() / bls::publicKeySerializedSize;
+	pubVec.resize(n);
+	for (size_t i = 0; i < n; i++) {
+		if (!pubVec[i].deserialize(&buf[i * bls::publicKeySerializedSize], bls::publicKeySerializedSize, mode)) return false;
+	}
+	return true;
+}
+
+CYBOZU_TEST_AUTO(deserializeTrusted)
+{
+	const size_t n = 32;
+	std::vector<uint8_t> buf(n * bls::publicKeySerializedSize);
+	bls::PublicKeyVec pubVec(n);
+	for (size_t i = 0; i < n; i++) {
+		bls::SecretKey sec;
+		sec.init();
+		sec.getPublicKey(pubVec[i]);
+		pubVec[i].serialize(&buf[i * bls::publicKeySerializedSize]);
+	}
+	bls::PublicKeyVec pubVec1, pubVec2;
+	CYBOZU_TEST_ASSERT(loadPublicKeyVec(pubVec1, buf, bls::DeserializeChecked));
+	CYBOZU_TEST_ASSERT(loadPublicKeyVec(pubVec2, buf, bls::DeserializeTrusted));
+	CYBOZU_TEST_ASSERT(pubVec1 == pubVec);
+	CYBOZU_TEST_ASSERT(pubVec2 == pubVec);
+	// the format is checked even if trusted
+	const uint8_t c = buf[bls::publicKeySerializedSize - 1];
+	buf[bls::publicKeySerializedSize - 1] = c | 0xc0;
+	CYBOZU_TEST_ASSERT(!loadPublicKeyVec(pubVec2, buf, bls::DeserializeTrusted));
+	buf[bls::publicKeySerializedSize - 1] = c;
+	CYBOZU_TEST_ASSERT(loadPublicKeyVec(pubVec2, buf, bls::DeserializeTrusted));
+}
+
+CYBOZU_TEST_AUTO(PublicKeyRegistry)
+{
+	const size_t n = 100;
+	const std::string textPath = "bls_registry_test.txt";
+	const std::string path = "bls_registry_test.bin";
+	bls::PublicKeyVec pubVec(n);
+	{
+		std::ofstream ofs(textPath.c_str());
+		for (size_t i = 0; i < n; i++) {
+			bls::SecretKey sec;
+			sec.init();
+			sec.getPublicKey(pubVec[i]);
+			ofs << pubVec[i] << '\n';
+		}
+	}
+	bls::ThreadPool pool(4);
+	bls::PublicKeyRegistry::convertFromText(path, textPath, &pool);
+	{
+		bls::PublicKeyRegistry reg(path, bls::DeserializeTrusted, 10);
+		CYBOZU_TEST_EQUAL(reg.size(), n);
+		for (int j = 0; j < 2; j++) {
+			for (size_t i = 0; i < n; i++) {
+				bls::PublicKey pub;
+				reg.get(pub, i);
+				CYBOZU_TEST_EQUAL(pub, pubVec[i]);
+			}
+		}
+		bls::PublicKey pub;
+		CYBOZU_TEST_EXCEPTION(reg.get(pub, n), std::exception);
+	}
+	bls::PublicKeyRegistry::build(path, pubVec.data(), 3);
+	CYBOZU_TEST_ASSERT(!std::ifstream((path + ".tmp").c_str()));
+	CYBOZU_TEST_EXCEPTION(bls::PublicKeyRegistry::build("bls_no_such_dir/" + path, pubVec.data(), 3), std::exception);
+	{
+		bls::PublicKeyRegistry reg(path);
+		CYBOZU_TEST_EQUAL(reg.size(), 3u);
+		bls::PublicKey pub;
+		reg.get(pub, 2);
+		CYBOZU_TEST_EQUAL(pub, pubVec[2]);
 	}
+	{
+		std::ofstream ofs(path.c_str(), std::ios::binary);
+		ofs << "not a registry of public keys";
+	}
+	CYBOZU_TEST_EXCEPTION(bls::PublicKeyRegistry reg(path), std::exception);
+	remove(path.c_str());
+	remove(textPath.c_str());
 }
 
 template<class T>
@@ -83,6 +282,18 @@ CYBOZU_TEST_AUTO(SecretKey_set)
 	testSet<bls::SecretKey>();
 }
 
+CYBOZU_TEST_AUTO(setHashOf)
+{
+	const uint64_t one[bls::keySize] = { 1 };
+	bls::SecretKey sec;
+	sec.set(one);
+	const std::string m = "abc";
+	bls::Sign s1, s2;
+	sec.sign(s1, m);
+	s2.setHashOf(m);
+	CYBOZU_TEST_EQUAL(s1, s2);
+}
+
 CYBOZU_TEST_AUTO(k_of_n)
 {
 	const std::string m = "abc";
@@ -326,3 +537,819 @@ CYBOZU_TEST_AUTO(add)
 	sec2.sign(s2, m);
 	CYBOZU_TEST_ASSERT((s1 + s2).verify(pub1 + pub2, m));
 }
+
+CYBOZU_TEST_AUTO(verifyBatch)
+{
+	const size_t n = 10;
+	bls::SignVec signVec(n);
+	bls::PublicKeyVec pubVec(n);
+	std::vector<std::string> msgVec(n);
+	for (size_t i = 0; i < n; i++) {
+		bls::SecretKey sec;
+		sec.init();
+		sec.getPublicKey(pubVec[i]);
+		msgVec[i] = "batch";
+		msgVec[i] += char('0' + i);
+		sec.sign(signVec[i], msgVec[i]);
+	}
+	std::vector<size_t> badIdxVec;
+	CYBOZU_TEST_ASSERT(bls::verifyBatch(signVec.data(), pubVec.data(), msgVec.data(), n, &badIdxVec));
+	CYBOZU_TEST_ASSERT(badIdxVec.empty());
+	CYBOZU_TEST_ASSERT(bls::verifyBatch(signVec.data(), pubVec.data(), msgVec.data(), 0));
+
+	msgVec[2] += "x";
+	std::swap(signVec[7], signVec[8]);
+	CYBOZU_TEST_ASSERT(!bls::verifyBatch(signVec.data(), pubVec.data(), msgVec.data(), n));
+	CYBOZU_TEST_ASSERT(!bls::verifyBatch(signVec.data(), pubVec.data(), msgVec.data(), n, &badIdxVec));
+	CYBOZU_TEST_EQUAL(badIdxVec.size(), 3);
+	if (badIdxVec.size() == 3) {
+		CYBOZU_TEST_EQUAL(badIdxVec[0], 2);
+		CYBOZU_TEST_EQUAL(badIdxVec[1], 7);
+		CYBOZU_TEST_EQUAL(badIdxVec[2], 8);
+	}
+}
+
+CYBOZU_TEST_AUTO(PreparedPublicKey)
+{
+	bls::SecretKey sec;
+	sec.init();
+	bls::PublicKey pub;
+	sec.getPublicKey(pub);
+	bls::PreparedPublicKey ppub(pub);
+	{
+		bls::PublicKey pub2;
+		ppub.getPublicKey(pub2);
+		CYBOZU_TEST_EQUAL(pub, pub2);
+	}
+	const std::string m = "prepared";
+	bls::Sign s;
+	sec.sign(s, m);
+	CYBOZU_TEST_ASSERT(s.verify(ppub, m));
+	CYBOZU_TEST_ASSERT(!s.verify(ppub, m + "a"));
+	bls::PreparedPublicKey ppub2;
+	CYBOZU_TEST_EXCEPTION(s.verify(ppub2, m), std::exception);
+	ppub2 = ppub;
+	CYBOZU_TEST_ASSERT(s.verify(ppub2, m));
+	CYBOZU_TEST_ASSERT(ppub.getMemorySize() > sizeof(ppub));
+}
+
+CYBOZU_TEST_AUTO(verifyAggregate)
+{
+	const size_t n = 10;
+	bls::PublicKeyVec pubVec(n);
+	std::vector<std::string> msgVec(n);
+	bls::Sign agg;
+	for (size_t i = 0; i < n; i++) {
+		bls::SecretKey sec;
+		sec.init();
+		sec.getPublicKey(pubVec[i]);
+		msgVec[i] = "aggregate";
+		msgVec[i] += char('0' + i);
+		bls::Sign s;
+		sec.sign(s, msgVec[i]);
+		if (i == 0) {
+			agg = s;
+		} else {
+			agg.add(s);
+		}
+	}
+	CYBOZU_TEST_ASSERT(agg.verifyAggregate(pubVec, msgVec));
+	CYBOZU_TEST_ASSERT(!agg.verifyAggregate(pubVec.data(), msgVec.data(), n - 1));
+	std::swap(msgVec[3], msgVec[4]);
+	CYBOZU_TEST_ASSERT(!agg.verifyAggregate(pubVec, msgVec));
+	std::swap(msgVec[3], msgVec[4]);
+	msgVec[5] = msgVec[6];
+	CYBOZU_TEST_ASSERT(!agg.verifyAggregate(pubVec, msgVec));
+}
+
+void addPublicKeyVec(bls::PublicKey& agg, const bls::PublicKeyVec& pubVec)
+{
+	agg = pubVec[0];
+	for (size_t i = 1; i < pubVec.size(); i++) {
+		agg.add(pubVec[i]);
+	}
+}
+
+CYBOZU_TEST_AUTO(fastAggregateVerify)
+{
+	const std::string m = "committee";
+	const size_t maxN = 64;
+	bls::SecretKeyVec secVec(maxN);
+	bls::PublicKeyVec allPubVec(maxN);
+	for (size_t i = 0; i < maxN; i++) {
+		secVec[i].init();
+		secVec[i].getPublicKey(allPubVec[i]);
+	}
+	bls::AggregatePublicKeyCache cache(4);
+	for (size_t n = 4; n <= maxN; n *= 2) {
+		bls::PublicKeyVec pubVec(allPubVec.begin(), allPubVec.begin() + n);
+		bls::Sign agg;
+		secVec[0].sign(agg, m);
+		for (size_t i = 1; i < n; i++) {
+			bls::Sign s;
+			secVec[i].sign(s, m);
+			agg.add(s);
+		}
+		bls::PublicKey aggPub1, aggPub2;
+		addPublicKeyVec(aggPub1, pubVec);
+		bls::AggregatePublicKeyCache::aggregate(aggPub2, pubVec.data(), n);
+		CYBOZU_TEST_EQUAL(aggPub1, aggPub2);
+		CYBOZU_TEST_ASSERT(bls::fastAggregateVerify(agg, pubVec.data(), n, m));
+		CYBOZU_TEST_ASSERT(!bls::fastAggregateVerify(agg, pubVec.data(), n - 1, m));
+		bls::StatsCounter c[bls::statsOpNum];
+		bls::resetStats();
+		CYBOZU_TEST_ASSERT(!cache.get(aggPub2, pubVec.data(), n));
+		bls::getStats(c);
+		const uint64_t missNormalizeN = c[bls::StatsNormalize].count;
+		bls::resetStats();
+		CYBOZU_TEST_ASSERT(cache.get(aggPub2, pubVec.data(), n));
+		bls::getStats(c);
+		CYBOZU_TEST_EQUAL(aggPub1, aggPub2);
+		// a hit of the Jacobian keys does one inversion for all of them as a miss does
+		CYBOZU_TEST_ASSERT(c[bls::StatsNormalize].count <= missNormalizeN);
+		CYBOZU_TEST_EQUAL(c[bls::StatsNormalize].count, bls::isStatsEnabled() ? 1u : 0u);
+		CYBOZU_TEST_EQUAL(c[bls::StatsSerialize].count, 0);
+		CYBOZU_TEST_ASSERT(bls::fastAggregateVerify(agg, pubVec.data(), n, m, &cache));
+		CYBOZU_TEST_ASSERT(!bls::fastAggregateVerify(agg, pubVec.data(), n, m + "a", &cache));
+		// the key does not depend on the coordinates of the points
+		bls::normalizeVec(pubVec.data(), n);
+		CYBOZU_TEST_ASSERT(cache.get(aggPub2, pubVec.data(), n));
+		CYBOZU_TEST_EQUAL(aggPub1, aggPub2);
+	}
+	CYBOZU_TEST_EQUAL(cache.size(), 4);
+	cache.clear();
+	CYBOZU_TEST_EQUAL(cache.size(), 0);
+}
+
+CYBOZU_TEST_AUTO(affine)
+{
+	const size_t n = 32;
+	bls::SecretKeyVec secVec(n);
+	bls::PublicKeyVec pubVec(n);
+	bls::SignVec signVec(n);
+	const std::string m = "affine";
+	bls::PublicKey sumPub;
+	bls::Sign sumSign;
+	for (size_t i = 0; i < n; i++) {
+		secVec[i].init();
+		secVec[i].getPublicKey(pubVec[i]);
+		secVec[i].sign(signVec[i], m);
+		if (i == 0) {
+			sumPub = pubVec[0];
+			sumSign = signVec[0];
+		} else {
+			sumPub.add(pubVec[i]);
+			sumSign.add(signVec[i]);
+		}
+	}
+	CYBOZU_TEST_EQUAL(sizeof(bls::AffinePublicKey) * 3, sizeof(bls::PublicKey) * 2);
+	CYBOZU_TEST_EQUAL(sizeof(bls::AffineSign) * 3, sizeof(bls::Sign) * 2);
+	{
+		bls::AffinePublicKey apub(pubVec[0]);
+		bls::PublicKey pub;
+		apub.get(pub);
+		CYBOZU_TEST_EQUAL(pub, pubVec[0]);
+		bls::AffineSign asign(signVec[0]);
+		bls::Sign sign;
+		asign.get(sign);
+		CYBOZU_TEST_EQUAL(sign, signVec[0]);
+		// the point at infinity
+		bls::AffinePublicKey zero(bls::PublicKey{});
+		CYBOZU_TEST_EQUAL(zero, bls::AffinePublicKey());
+		zero.get(pub);
+		CYBOZU_TEST_EQUAL(pub, bls::PublicKey());
+	}
+	std::vector<bls::AffinePublicKey> apubVec(n);
+	std::vector<bls::AffineSign> asignVec(n);
+	bls::ThreadPool pool(4);
+	bls::toAffineVec(apubVec.data(), pubVec.data(), n, &pool);
+	bls::toAffineVec(asignVec.data(), signVec.data(), n);
+	for (size_t i = 0; i < n; i++) {
+		CYBOZU_TEST_EQUAL(apubVec[i], bls::AffinePublicKey(pubVec[i]));
+		CYBOZU_TEST_EQUAL(asignVec[i], bls::AffineSign(signVec[i]));
+	}
+	bls::PublicKey aggPub;
+	bls::Sign aggSign;
+	aggPub.aggregate(apubVec.data(), n);
+	CYBOZU_TEST_EQUAL(aggPub, sumPub);
+	aggPub.aggregate(apubVec.data(), n, &pool);
+	CYBOZU_TEST_EQUAL(aggPub, sumPub);
+	aggSign.aggregate(asignVec.data(), n, &pool);
+	CYBOZU_TEST_EQUAL(aggSign, sumSign);
+	CYBOZU_TEST_ASSERT(aggSign.verify(aggPub, m));
+
+	bls::PublicKeyVec normPubVec = pubVec;
+	bls::SignVec normSignVec = signVec;
+	bls::normalizeVec(normPubVec.data(), n, &pool);
+	bls::normalizeVec(normSignVec.data(), n);
+	CYBOZU_TEST_ASSERT(normPubVec == pubVec);
+	CYBOZU_TEST_ASSERT(normSignVec == signVec);
+	bls::PublicKey pub = pubVec[1];
+	pub.normalize();
+	CYBOZU_TEST_EQUAL(pub, pubVec[1]);
+}
+
+void addSignVec(bls::Sign& agg, const bls::SignVec& signVec)
+{
+	agg = signVec[0];
+	for (size_t i = 1; i < signVec.size(); i++) {
+		agg.add(signVec[i]);
+	}
+}
+
+CYBOZU_TEST_AUTO(aggregate)
+{
+	// over some blocks of 1024 points
+	const size_t n = 3000;
+	const std::string m = "aggregate";
+	bls::PublicKeyVec pubVec(n);
+	bls::SignVec signVec(n);
+	// pubVec[i] = (i + 1) sQ and signVec[i] = (i + 1) s H(m) are cheaper than n keys
+	{
+		bls::SecretKey sec;
+		sec.init();
+		sec.getPublicKey(pubVec[0]);
+		sec.sign(signVec[0], m);
+		for (size_t i = 1; i < n; i++) {
+			pubVec[i] = pubVec[i - 1];
+			pubVec[i].add(pubVec[0]);
+			signVec[i] = signVec[i - 1];
+			signVec[i].add(signVec[0]);
+		}
+	}
+	bls::ThreadPool pool(4);
+	const size_t tbl[] = { 1, 2, 1023, 1024, 1025, 2049, n };
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(tbl); i++) {
+		const size_t k = tbl[i];
+		bls::PublicKey sumPub, aggPub;
+		bls::Sign sumSign, aggSign;
+		addPublicKeyVec(sumPub, bls::PublicKeyVec(pubVec.begin(), pubVec.begin() + k));
+		addSignVec(sumSign, bls::SignVec(signVec.begin(), signVec.begin() + k));
+		aggPub.aggregate(pubVec.data(), k);
+		aggSign.aggregate(signVec.data(), k);
+		CYBOZU_TEST_EQUAL(aggPub, sumPub);
+		CYBOZU_TEST_EQUAL(aggSign, sumSign);
+		aggPub = bls::PublicKey();
+		aggPub.aggregate(pubVec.data(), k, &pool);
+		aggSign.aggregate(signVec.data(), k, &pool);
+		CYBOZU_TEST_EQUAL(aggPub, sumPub);
+		CYBOZU_TEST_EQUAL(aggSign, sumSign);
+		CYBOZU_TEST_ASSERT(aggSign.verify(aggPub, m));
+	}
+	{
+		bls::Sign s = signVec[0];
+		s.aggregate(signVec.data(), 0);
+		CYBOZU_TEST_EQUAL(s, bls::Sign());
+	}
+}
+
+CYBOZU_TEST_AUTO(CommitteeAggregator)
+{
+	const size_t n = 300;
+	bls::PublicKeyVec pubVec(n);
+	{
+		bls::SecretKey sec;
+		sec.init();
+		sec.getPublicKey(pubVec[0]);
+		for (size_t i = 1; i < n; i++) {
+			pubVec[i] = pubVec[i - 1];
+			pubVec[i].add(pubVec[0]);
+		}
+	}
+	bls::CommitteeAggregator ca(pubVec);
+	CYBOZU_TEST_EQUAL(ca.size(), n);
+	std::vector<uint8_t> bitmap((n + 7) / 8);
+	// participation of 0%, 10%, 50%, 90% and 100%
+	const int tbl[] = { 0, 10, 50, 90, 100 };
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(tbl); i++) {
+		std::fill(bitmap.begin(), bitmap.end(), 0);
+		bls::PublicKey sum;
+		size_t c = 0;
+		for (size_t j = 0; j < n; j++) {
+			if (int((j * 37) % 100) < tbl[i]) {
+				bitmap[j / 8] |= 1 << (j % 8);
+				sum.add(pubVec[j]);
+				c++;
+			}
+		}
+		bls::PublicKey agg;
+		size_t addNum = ca.aggregate(agg, bitmap.data(), bitmap.size());
+		CYBOZU_TEST_EQUAL(agg, sum);
+		if (tbl[i] == 90) CYBOZU_TEST_ASSERT(addNum * 5 < c);
+		if (tbl[i] == 0 || tbl[i] == 100) CYBOZU_TEST_EQUAL(addNum, 0);
+	}
+	CYBOZU_TEST_EXCEPTION(ca.aggregate(pubVec[0], bitmap.data(), bitmap.size() - 1), std::exception);
+	// the unused bits of the last byte
+	bitmap[bitmap.size() - 1] |= 0x80;
+	CYBOZU_TEST_EXCEPTION(ca.aggregate(pubVec[0], bitmap.data(), bitmap.size()), std::exception);
+	bitmap[bitmap.size() - 1] &= 0x7f;
+	CYBOZU_TEST_EXCEPTION(bls::CommitteeAggregator(pubVec, 0), std::exception);
+}
+
+CYBOZU_TEST_AUTO(ThreadPool)
+{
+	const size_t n = 64;
+	const size_t k = 5;
+	bls::SecretKey sec;
+	sec.init();
+	bls::PublicKey pub;
+	sec.getPublicKey(pub);
+	std::vector<std::string> msgVec(n);
+	for (size_t i = 0; i < n; i++) {
+		msgVec[i] = "pool";
+		msgVec[i] += char('0' + i);
+	}
+	bls::SecretKeyVec msk;
+	sec.getMasterSecretKey(msk, k);
+	bls::PublicKeyVec mpk;
+	bls::getMasterPublicKey(mpk, msk);
+	bls::IdVec idVec(n);
+	for (size_t i = 0; i < n; i++) {
+		idVec[i] = int(i + 1);
+	}
+	bls::SignVec signVec0(n);
+	bls::signBatch(signVec0.data(), sec, msgVec.data(), n);
+	bls::SecretKeyVec secVec0(n);
+	bls::deriveSecretShares(msk, idVec.data(), n, secVec0.data());
+	bls::PublicKeyVec pubVec0(n);
+	bls::getPublicKeyBatch(pubVec0.data(), secVec0.data(), n);
+
+	const bls::PublicKeyVec pubVec(n, pub);
+	for (size_t threadNum = 1; threadNum <= 4; threadNum *= 2) {
+		bls::ThreadPool pool(threadNum);
+		CYBOZU_TEST_EQUAL(pool.getThreadNum(), threadNum);
+		bls::SignVec signVec(n);
+		bls::signBatch(signVec.data(), sec, msgVec.data(), n, &pool);
+		CYBOZU_TEST_ASSERT(signVec == signVec0);
+		CYBOZU_TEST_ASSERT(bls::verifyBatch(signVec.data(), pubVec.data(), msgVec.data(), n, 0, &pool));
+		bls::SecretKeyVec secVec(n);
+		bls::deriveSecretShares(msk, idVec.data(), n, secVec.data(), &pool);
+		CYBOZU_TEST_ASSERT(secVec == secVec0);
+		bls::PublicKeyVec sharePubVec(n);
+		bls::derivePublicShares(mpk, idVec.data(), n, sharePubVec.data(), &pool);
+		CYBOZU_TEST_ASSERT(sharePubVec == pubVec0);
+		bls::getPublicKeyBatch(sharePubVec.data(), secVec.data(), n, &pool);
+		CYBOZU_TEST_ASSERT(sharePubVec == pubVec0);
+		bls::PublicKey agg1, agg2;
+		bls::AggregatePublicKeyCache::aggregate(agg1, pubVec0.data(), n);
+		bls::AggregatePublicKeyCache::aggregate(agg2, pubVec0.data(), n, &pool);
+		CYBOZU_TEST_EQUAL(agg1, agg2);
+
+		std::swap(signVec[3], signVec[4]);
+		std::vector<size_t> badIdxVec;
+		CYBOZU_TEST_ASSERT(!bls::verifyBatch(signVec.data(), pubVec.data(), msgVec.data(), n, &badIdxVec, &pool));
+		CYBOZU_TEST_EQUAL(badIdxVec.size(), 2);
+		std::swap(signVec[3], signVec[4]);
+
+		// a task can run a bulk operation on the same pool
+		std::vector<int> okVec(4);
+		pool.run(okVec.size(), [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				okVec[i] = bls::verifyBatch(signVec.data(), pubVec.data(), msgVec.data(), n, 0, &pool);
+			}
+		});
+		CYBOZU_TEST_ASSERT(okVec == std::vector<int>(4, 1));
+	}
+	{
+		bls::ThreadPool pool(2);
+		CYBOZU_TEST_EXCEPTION(pool.run(10, [](size_t, size_t) { throw std::runtime_error("err"); }), std::exception);
+	}
+}
+
+struct CounterRand {
+	uint8_t c;
+};
+
+size_t readCounterRand(void *self, void *buf, size_t bufSize)
+{
+	CounterRand *r = (CounterRand*)self;
+	uint8_t *p = (uint8_t*)buf;
+	for (size_t i = 0; i < bufSize; i++) {
+		p[i] = r->c++;
+	}
+	return bufSize;
+}
+
+size_t readBadRand(void *, void *, size_t)
+{
+	return 0;
+}
+
+CYBOZU_TEST_AUTO(setRandFunc)
+{
+	CounterRand r1 = {}, r2 = {};
+	bls::SecretKey sec1, sec2;
+	bls::setRandFunc(&r1, readCounterRand);
+	sec1.init();
+	bls::setRandFunc(&r2, readCounterRand);
+	sec2.init();
+	CYBOZU_TEST_EQUAL(sec1, sec2);
+	bls::setRandFunc(0, readBadRand);
+	CYBOZU_TEST_EXCEPTION(sec1.init(), std::exception);
+	bls::setRandFunc(0, 0);
+	sec1.init();
+	sec2.init();
+	CYBOZU_TEST_ASSERT(sec1 != sec2);
+}
+
+/*
+	make keys in several threads at once
+	make test BLS_TSAN=1 checks it by ThreadSanitizer
+*/
+CYBOZU_TEST_AUTO(keyGenThread)
+{
+	const size_t N = 20;
+	const size_t k = 8;
+	size_t threadNum = std::thread::hardware_concurrency();
+	threadNum = std::min<size_t>(std::max<size_t>(threadNum, 2), 8);
+	std::vector<bls::SecretKeyVec> secVec(threadNum);
+	std::vector<std::thread> thVec;
+	for (size_t t = 0; t < threadNum; t++) {
+		thVec.push_back(std::thread([&secVec, t, N, k] {
+			bls::SecretKeyVec& v = secVec[t];
+			bls::SecretKeyVec msk;
+			for (size_t i = 0; i < N; i++) {
+				bls::SecretKey sec;
+				sec.init();
+				sec.getMasterSecretKey(msk, k);
+				v.insert(v.end(), msk.begin(), msk.end());
+			}
+		}));
+	}
+	for (size_t t = 0; t < threadNum; t++) {
+		thVec[t].join();
+	}
+	std::vector<std::string> strVec;
+	for (size_t t = 0; t < threadNum; t++) {
+		CYBOZU_TEST_EQUAL(secVec[t].size(), N * k);
+		for (size_t i = 0; i < secVec[t].size(); i++) {
+			uint8_t buf[bls::secretKeySerializedSize];
+			secVec[t][i].serialize(buf);
+			strVec.push_back(std::string((const char*)buf, sizeof(buf)));
+		}
+	}
+	std::sort(strVec.begin(), strVec.end());
+	CYBOZU_TEST_ASSERT(std::adjacent_find(strVec.begin(), strVec.end()) == strVec.end());
+}
+
+CYBOZU_TEST_AUTO(hashCache)
+{
+	bls::SecretKey sec;
+	sec.init();
+	bls::PublicKey pub;
+	sec.getPublicKey(pub);
+	const std::string m = "block hash";
+	bls::Sign s0;
+	sec.sign(s0, m);
+
+	bls::HashCacheStats stats;
+	bls::getHashCacheStats(stats);
+	CYBOZU_TEST_EQUAL(stats.capacity, 0);
+	CYBOZU_TEST_EQUAL(stats.size, 0);
+
+	bls::setHashCacheCapacity(2);
+	bls::Sign s;
+	sec.sign(s, m); // miss
+	CYBOZU_TEST_EQUAL(s, s0);
+	CYBOZU_TEST_ASSERT(s.verify(pub, m)); // hit
+	CYBOZU_TEST_ASSERT(s.verify(pub, m)); // hit
+	CYBOZU_TEST_ASSERT(!s.verify(pub, m + "a")); // miss
+	bls::getHashCacheStats(stats);
+	CYBOZU_TEST_EQUAL(stats.capacity, 2);
+	CYBOZU_TEST_EQUAL(stats.size, 2);
+	CYBOZU_TEST_EQUAL(stats.hitNum, 2);
+	CYBOZU_TEST_EQUAL(stats.missNum, 2);
+	sec.sign(s, m + "b"); // miss and remove m
+	CYBOZU_TEST_ASSERT(s.verify(pub, m + "b")); // hit
+	CYBOZU_TEST_ASSERT(!s.verify(pub, m)); // miss
+	bls::getHashCacheStats(stats);
+	CYBOZU_TEST_EQUAL(stats.size, 2);
+	CYBOZU_TEST_EQUAL(stats.hitNum, 3);
+	CYBOZU_TEST_EQUAL(stats.missNum, 4);
+
+	bls::setHashCacheCapacity(1024);
+	CYBOZU_TEST_ASSERT(s0.verify(pub, m));
+	bls::clearHashCache();
+	bls::getHashCacheStats(stats);
+	CYBOZU_TEST_EQUAL(stats.size, 0);
+	CYBOZU_TEST_EQUAL(stats.hitNum, 0);
+	bls::setHashCacheCapacity(0);
+	CYBOZU_TEST_ASSERT(s0.verify(pub, m));
+	bls::getHashCacheStats(stats);
+	CYBOZU_TEST_EQUAL(stats.missNum, 0);
+}
+
+CYBOZU_TEST_AUTO(stats)
+{
+	bls::SecretKey sec;
+	sec.init();
+	const std::string m = "abc";
+	bls::resetStats();
+	bls::PublicKey pub;
+	sec.getPublicKey(pub);
+	bls::Sign s;
+	sec.sign(s, m);
+	CYBOZU_TEST_ASSERT(s.verify(pub, m));
+	uint8_t buf[bls::publicKeySerializedSize];
+	pub.serialize(buf);
+	CYBOZU_TEST_ASSERT(pub.deserialize(buf, sizeof(buf)));
+
+	bls::StatsCounter c[bls::statsOpNum];
+	bls::getStats(c);
+	if (bls::isStatsEnabled()) {
+		const struct {
+			bls::StatsOp op;
+			uint64_t count;
+		} tbl[] = {
+			{ bls::StatsMillerLoop, 2 },
+			{ bls::StatsFinalExp, 1 },
+			{ bls::StatsG1Mul, 1 },
+			{ bls::StatsG2Mul, 1 },
+			{ bls::StatsMulVec, 0 },
+			{ bls::StatsHashToG1, 2 },
+			{ bls::StatsMapToG1, 2 },
+			{ bls::StatsSerialize, 1 },
+			{ bls::StatsDeserialize, 1 },
+			{ bls::StatsGetStr, 0 },
+			{ bls::StatsSetStr, 0 },
+			{ bls::StatsLagrangeInv, 0 },
+			{ bls::StatsNormalize, 1 },
+		};
+		CYBOZU_TEST_EQUAL(CYBOZU_NUM_OF_ARRAY(tbl), bls::statsOpNum);
+		for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(tbl); i++) {
+			const bls::StatsCounter& x = c[tbl[i].op];
+			CYBOZU_TEST_EQUAL(x.count, tbl[i].count);
+			uint64_t sum = 0;
+			for (size_t j = 0; j < bls::statsHistogramSize; j++) {
+				sum += x.histogram[j];
+			}
+			CYBOZU_TEST_EQUAL(sum, x.count);
+		}
+		CYBOZU_TEST_ASSERT(c[bls::StatsMillerLoop].totalNsec > 0);
+	}
+	bls::resetStats();
+	bls::getStats(c);
+	for (size_t i = 0; i < bls::statsOpNum; i++) {
+		CYBOZU_TEST_EQUAL(c[i].count, 0);
+		CYBOZU_TEST_EQUAL(c[i].totalNsec, 0);
+	}
+	CYBOZU_TEST_EQUAL(std::string(bls::getStatsOpName(bls::StatsLagrangeInv)), "LagrangeInv");
+}
+
+CYBOZU_TEST_AUTO(MessageHasher)
+{
+	bls::SecretKey sec;
+	sec.init();
+	bls::PublicKey pub;
+	sec.getPublicKey(pub);
+	std::string m;
+	for (int i = 0; i < 10000; i++) {
+		m += char(i * 7);
+	}
+	bls::Sign s0, s;
+	sec.sign(s0, m);
+	sec.sign(s, m.data(), m.size());
+	CYBOZU_TEST_EQUAL(s, s0);
+	CYBOZU_TEST_ASSERT(s.verify(pub, m.data(), m.size()));
+	CYBOZU_TEST_ASSERT(!s.verify(pub, m.data(), m.size() - 1));
+	bls::PreparedPublicKey ppub(pub);
+	CYBOZU_TEST_ASSERT(s.verify(ppub, m.data(), m.size()));
+
+	bls::MessageHasher h;
+	const size_t chunkSize = 1000;
+	for (size_t pos = 0; pos < m.size(); pos += chunkSize) {
+		h.update(&m[pos], std::min(chunkSize, m.size() - pos));
+	}
+	sec.sign(s, h);
+	CYBOZU_TEST_EQUAL(s, s0);
+	// h is reset by sign
+	h.update(m);
+	CYBOZU_TEST_ASSERT(s0.verify(pub, h));
+	h.update(m.data(), 1);
+	h.reset();
+	h.update(m);
+	CYBOZU_TEST_ASSERT(s0.verify(ppub, h));
+	h.update(m.data(), m.size() - 1);
+	CYBOZU_TEST_ASSERT(!s0.verify(pub, h));
+
+	const size_t n = 3;
+	const char *msgVec[n] = { "abc", "abd", "ab" };
+	const size_t msgSizeVec[n] = { 3, 3, 2 };
+	bls::SecretKeyVec secVec(n);
+	bls::PublicKeyVec pubVec(n);
+	bls::SignVec signVec(n);
+	for (size_t i = 0; i < n; i++) {
+		secVec[i].init();
+		secVec[i].getPublicKey(pubVec[i]);
+		secVec[i].sign(signVec[i], msgVec[i], msgSizeVec[i]);
+	}
+	CYBOZU_TEST_ASSERT(bls::verifyBatch(signVec.data(), pubVec.data(), msgVec, msgSizeVec, n));
+	bls::Sign agg = signVec[0] + signVec[1] + signVec[2];
+	CYBOZU_TEST_ASSERT(agg.verifyAggregate(pubVec.data(), msgVec, msgSizeVec, n));
+	const size_t sameSizeVec[n] = { 2, 3, 2 }; // "ab" twice
+	CYBOZU_TEST_ASSERT(!agg.verifyAggregate(pubVec.data(), msgVec, sameSizeVec, n));
+	bls::signBatch(signVec.data(), sec, msgVec, msgSizeVec, n);
+	CYBOZU_TEST_ASSERT(bls::fastAggregateVerify(signVec[2], &pub, 1, msgVec[2], msgSizeVec[2]));
+}
+
+/*
+	sum of n scalar multiplications by G::mul of mcl
+	which does not use the GLV, GLS and Pippenger code of bls::mulVec
+	Sign, PublicKey and SecretKey are G1, G2 and Fr inside
+*/
+template<class G, class T>
+void mulVecNaive(T& out, const T *vec, const bls::SecretKey *coeffVec, size_t n)
+{
+	G& sum = reinterpret_cast<G&>(out);
+	sum.clear();
+	for (size_t i = 0; i < n; i++) {
+		G t;
+		G::mul(t, reinterpret_cast<const G&>(vec[i]), reinterpret_cast<const mcl::bn256::Fr&>(coeffVec[i]));
+		sum += t;
+	}
+}
+
+CYBOZU_TEST_AUTO(mulVec)
+{
+	const size_t maxN = 1000;
+	const std::string m = "mulVec";
+	bls::SecretKeyVec coeffVec(maxN), oneVec(maxN);
+	bls::SignVec signVec(maxN);
+	bls::PublicKeyVec pubVec(maxN);
+	const uint64_t one[] = { 1, 0, 0, 0 };
+	// the keys (i + 1) sec are cheaper than maxN keys
+	bls::SecretKey sec;
+	sec.init();
+	sec.getPublicKey(pubVec[0]);
+	sec.sign(signVec[0], m);
+	for (size_t i = 0; i < maxN; i++) {
+		if (i > 0) {
+			pubVec[i] = pubVec[i - 1];
+			pubVec[i].add(pubVec[0]);
+			signVec[i] = signVec[i - 1];
+			signVec[i].add(signVec[0]);
+		}
+		coeffVec[i].init();
+		oneVec[i].set(one);
+	}
+	coeffVec[1] = bls::SecretKey(); // zero
+	coeffVec[2].set(one);
+	const size_t nTbl[] = { 1, 2, 3, 10, 33, 100, maxN };
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(nTbl); i++) {
+		const size_t n = nTbl[i];
+		bls::Sign s, sSum = signVec[0];
+		bls::PublicKey pub, pubSum = pubVec[0];
+		for (size_t j = 1; j < n; j++) {
+			sSum.add(signVec[j]);
+			pubSum.add(pubVec[j]);
+		}
+		bls::mulVec(s, signVec.data(), oneVec.data(), n);
+		CYBOZU_TEST_EQUAL(s, sSum);
+		bls::mulVec(pub, pubVec.data(), oneVec.data(), n);
+		CYBOZU_TEST_EQUAL(pub, pubSum);
+		// sum_i c_i sec_i H(m) is the sign of sum_i c_i sec_i Q
+		bls::mulVec(s, signVec.data(), coeffVec.data(), n);
+		bls::mulVec(pub, pubVec.data(), coeffVec.data(), n);
+		CYBOZU_TEST_ASSERT(s.verify(pub, m));
+		bls::Sign s2;
+		mulVecNaive<mcl::bn256::G1>(s2, signVec.data(), coeffVec.data(), n);
+		CYBOZU_TEST_EQUAL(s, s2);
+		bls::PublicKey pub2;
+		mulVecNaive<mcl::bn256::G2>(pub2, pubVec.data(), coeffVec.data(), n);
+		CYBOZU_TEST_EQUAL(pub, pub2);
+	}
+	{
+		bls::Sign s;
+		bls::mulVec(s, signVec.data(), coeffVec.data(), 0);
+		CYBOZU_TEST_EQUAL(s, bls::Sign());
+		bls::mulVec(s, signVec.data() + 1, coeffVec.data() + 1, 1);
+		CYBOZU_TEST_EQUAL(s, bls::Sign());
+	}
+}
+
+CYBOZU_TEST_AUTO(LagrangeContext)
+{
+	const std::string m = "LagrangeContext";
+	const size_t n = 30;
+	bls::SecretKey sec0;
+	sec0.init();
+	bls::PublicKey pub0;
+	sec0.getPublicKey(pub0);
+	bls::Sign s0;
+	sec0.sign(s0, m);
+	bls::LagrangeContext ctx(n);
+	CYBOZU_TEST_EQUAL(ctx.getN(), n);
+	// k < n - k and k > n - k use the different methods
+	const size_t kTbl[] = { 2, 3, 4, 15, 16, 20, 29, 30 };
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(kTbl); i++) {
+		const size_t k = kTbl[i];
+		bls::SecretKeyVec msk;
+		sec0.getMasterSecretKey(msk, k);
+		bls::SecretKeyVec secVec(k);
+		bls::PublicKeyVec pubVec(k);
+		bls::SignVec signVec(k);
+		bls::IdVec idVec(k);
+		for (size_t j = 0; j < k; j++) {
+			// distinct ids in the reverse order
+			idVec[j] = int(k <= n / 7 ? n - j * 7 : n - j);
+			secVec[j].set(msk, idVec[j]);
+			secVec[j].getPublicKey(pubVec[j]);
+			secVec[j].sign(signVec[j], m);
+		}
+		bls::SecretKey sec;
+		sec.recover(secVec, idVec, ctx);
+		CYBOZU_TEST_EQUAL(sec, sec0);
+		bls::PublicKey pub;
+		pub.recover(pubVec, idVec, ctx);
+		CYBOZU_TEST_EQUAL(pub, pub0);
+		bls::Sign s;
+		s.recover(signVec, idVec, ctx);
+		CYBOZU_TEST_EQUAL(s, s0);
+		sec.recover(secVec, idVec);
+		CYBOZU_TEST_EQUAL(sec, sec0);
+	}
+	{
+		bls::SecretKeyVec secVec(2);
+		bls::IdVec idVec(2);
+		secVec[0].init();
+		secVec[1].init();
+		bls::SecretKey sec;
+		idVec[0] = 1;
+		idVec[1] = int(n + 1);
+		CYBOZU_TEST_EXCEPTION(sec.recover(secVec, idVec, ctx), std::exception);
+		idVec[1] = 0;
+		CYBOZU_TEST_EXCEPTION(sec.recover(secVec, idVec, ctx), std::exception);
+		idVec[1] = 1;
+		CYBOZU_TEST_EXCEPTION(sec.recover(secVec, idVec, ctx), std::exception);
+		CYBOZU_TEST_EXCEPTION(sec.recover(secVec, idVec), std::exception);
+	}
+}
+
+CYBOZU_TEST_AUTO(deriveShares)
+{
+	bls::SecretKey sec0;
+	sec0.init();
+	const size_t kTbl[] = { 2, 3, 10 };
+	for (size_t ki = 0; ki < CYBOZU_NUM_OF_ARRAY(kTbl); ki++) {
+		const size_t k = kTbl[ki];
+		bls::SecretKeyVec msk;
+		sec0.getMasterSecretKey(msk, k);
+		bls::PublicKeyVec mpk;
+		bls::getMasterPublicKey(mpk, msk);
+		// runs of consecutive ids shorter and longer than k
+		bls::IdVec idVec;
+		for (int i = 1; i <= 50; i++) idVec.push_back(i);
+		idVec.push_back(100);
+		idVec.push_back(102);
+		for (int i = 200; i < 200 + (int)k; i++) idVec.push_back(i);
+		for (int i = 300; i <= 300 + (int)k; i++) idVec.push_back(i);
+		idVec.push_back(7);
+		const size_t n = idVec.size();
+		bls::SecretKeyVec secVec(n);
+		bls::PublicKeyVec pubVec(n);
+		bls::deriveSecretShares(msk, idVec.data(), n, secVec.data());
+		bls::derivePublicShares(mpk, idVec.data(), n, pubVec.data());
+		for (size_t i = 0; i < n; i++) {
+			bls::SecretKey sec;
+			sec.set(msk, idVec[i]);
+			CYBOZU_TEST_EQUAL(secVec[i], sec);
+			bls::PublicKey pub;
+			pub.set(mpk, idVec[i]);
+			CYBOZU_TEST_EQUAL(pubVec[i], pub);
+		}
+	}
+}
+
+CYBOZU_TEST_AUTO(publicKeyTable)
+{
+	CYBOZU_TEST_EQUAL(bls::getPublicKeyTableWindow(), 4);
+	const size_t n = 16;
+	bls::SecretKeyVec secVec(n);
+	bls::PublicKeyVec pubVec(n);
+	for (size_t i = 0; i < n; i++) {
+		secVec[i].init();
+		secVec[i].getPublicKey(pubVec[i]);
+	}
+	const uint64_t one[] = { 1, 0, 0, 0 };
+	secVec[0] = bls::SecretKey();
+	secVec[0].getPublicKey(pubVec[0]);
+	secVec[1].set(one);
+	secVec[1].getPublicKey(pubVec[1]);
+	CYBOZU_TEST_EXCEPTION(bls::setPublicKeyTableWindow(0), std::exception);
+	CYBOZU_TEST_EXCEPTION(bls::setPublicKeyTableWindow(bls::maxPublicKeyTableWindow + 1), std::exception);
+	size_t prevSize = 0;
+	for (size_t w = 1; w <= 10; w++) {
+		bls::setPublicKeyTableWindow(w);
+		CYBOZU_TEST_EQUAL(bls::getPublicKeyTableWindow(), w);
+		for (size_t i = 0; i < n; i++) {
+			bls::PublicKey pub;
+			secVec[i].getPublicKey(pub);
+			CYBOZU_TEST_EQUAL(pub, pubVec[i]);
+		}
+		const size_t size = bls::getPublicKeyTableMemorySize();
+		CYBOZU_TEST_ASSERT(size > prevSize);
+		prevSize = size;
+	}
+	bls::setPublicKeyTableWindow(4);
+	CYBOZU_TEST_EQUAL(bls::getPublicKeyTableWindow(), 4);
+}
@@ -0,0 +1,142 @@
+#include <cybozu/test.hpp>
+#include <cybozu/random_generator.hpp>
+#include "../src/bls_glv.hpp"
+#include "../src/bls_qtbl.hpp"
+
+using namespace mcl::bn256;
+
+cybozu::RandomGenerator rg;
+bls::glv::GLV1 glv1;
+G1 P;
+
+CYBOZU_TEST_AUTO(init)
+{
+	BN::init(mcl::bn::CurveFp254BNb);
+	Fr::init(BN::param.r);
+	mcl::bn::MapTo<Fp> mapTo;
+	mapTo.calcG1(P, Fp(123));
+	glv1.init(BN::param.r, BN::param.p, P);
+	Fr lambda;
+	lambda.setStr(glv1.lambda.get_str(), 10);
+	G1 Q1, Q2;
+	glv1.mulLambda(Q1, P);
+	G1::mul(Q2, P, lambda);
+	CYBOZU_TEST_EQUAL(Q1, Q2);
+	// the constants generated at build time
+	bls::glv::GLV1 glv1b;
+	glv1b.set(*reinterpret_cast<const Fp*>(bls::qtbl::glv1Beta), bls::qtbl::glv1Int);
+	CYBOZU_TEST_EQUAL(glv1b.beta, glv1.beta);
+	for (size_t i = 0; i < bls::glv::GLV1::intN; i++) {
+		CYBOZU_TEST_EQUAL(glv1b.getInt(i), glv1.getInt(i));
+	}
+}
+
+CYBOZU_TEST_AUTO(split)
+{
+	const mpz_class& r = BN::param.r;
+	for (int i = 0; i < 1000; i++) {
+		Fr x;
+		x.setRand(rg);
+		mpz_class k, k0, k1;
+		bls::glv::getMpz(k, x);
+		glv1.split(k0, k1, x);
+		mpz_class t = (k0 + k1 * glv1.lambda - k) % r;
+		CYBOZU_TEST_EQUAL(t, 0);
+		CYBOZU_TEST_ASSERT(mpz_sizeinbase(k0.get_mpz_t(), 2) <= 128);
+		CYBOZU_TEST_ASSERT(mpz_sizeinbase(k1.get_mpz_t(), 2) <= 128);
+	}
+}
+
+CYBOZU_TEST_AUTO(mul)
+{
+	Fr x;
+	G1 Q1, Q2;
+	const int tbl[] = { 0, 1, 2, 3, 31, 32, -1, -2 };
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(tbl); i++) {
+		x = tbl[i];
+		G1::mul(Q1, P, x);
+		glv1.mul(Q2, P, x);
+		CYBOZU_TEST_EQUAL(Q1, Q2);
+	}
+	for (int i = 0; i < 100; i++) {
+		x.setRand(rg);
+		G1::mul(Q1, P, x);
+		glv1.mul(Q2, P, x);
+		CYBOZU_TEST_EQUAL(Q1, Q2);
+		// Q2 is not normalized
+		glv1.mul(Q2, Q2, x);
+		G1::mul(Q1, Q1, x);
+		CYBOZU_TEST_EQUAL(Q1, Q2);
+	}
+}
+
+bls::glv::GLS2 gls2;
+G2 Q;
+
+CYBOZU_TEST_AUTO(initGLS)
+{
+	Q.set(
+		Fp2("12723517038133731887338407189719511622662176727675373276651903807414909099441", "4168783608814932154536427934509895782246573715297911553964171371032945126671"),
+		Fp2("13891744915211034074451795021214165905772212241412891944830863846330766296736", "7937318970632701341203597196594272556916396164729705624521405069090520231616")
+	);
+	gls2.init(BN::param.r, BN::param.p, BN::param.z, BN::param.xi, Q);
+	Fr p;
+	p.setStr(mpz_class(BN::param.p % BN::param.r).get_str(), 10);
+	G2 R1, R2;
+	gls2.psi(R1, Q);
+	G2::mul(R2, Q, p);
+	CYBOZU_TEST_EQUAL(R1, R2);
+	// the constants generated at build time
+	bls::glv::GLS2 gls2b;
+	gls2b.set(reinterpret_cast<const Fp2*>(bls::qtbl::gls2G), bls::qtbl::gls2Int);
+	CYBOZU_TEST_EQUAL(gls2b.gx, gls2.gx);
+	CYBOZU_TEST_EQUAL(gls2b.gy, gls2.gy);
+	for (size_t i = 0; i < bls::glv::GLS2::intN; i++) {
+		CYBOZU_TEST_EQUAL(gls2b.getInt(i), gls2.getInt(i));
+	}
+}
+
+CYBOZU_TEST_AUTO(splitGLS)
+{
+	const mpz_class& r = BN::param.r;
+	const mpz_class lambda = BN::param.p % r;
+	for (int i = 0; i < 1000; i++) {
+		Fr x;
+		x.setRand(rg);
+		mpz_class k, v[4];
+		bls::glv::getMpz(k, x);
+		gls2.split(v, x);
+		mpz_class t = v[3];
+		for (int j = 2; j >= 0; j--) {
+			t = t * lambda + v[j];
+		}
+		t = (t - k) % r;
+		CYBOZU_TEST_EQUAL(t, 0);
+		for (int j = 0; j < 4; j++) {
+			CYBOZU_TEST_ASSERT(mpz_sizeinbase(v[j].get_mpz_t(), 2) <= 66);
+		}
+	}
+}
+
+CYBOZU_TEST_AUTO(mulGLS)
+{
+	Fr x;
+	G2 R1, R2;
+	const int tbl[] = { 0, 1, 2, 3, 31, 32, -1, -2 };
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(tbl); i++) {
+		x = tbl[i];
+		G2::mul(R1, Q, x);
+		gls2.mul(R2, Q, x);
+		CYBOZU_TEST_EQUAL(R1, R2);
+	}
+	for (int i = 0; i < 100; i++) {
+		x.setRand(rg);
+		G2::mul(R1, Q, x);
+		gls2.mul(R2, Q, x);
+		CYBOZU_TEST_EQUAL(R1, R2);
+		// R2 is not normalized
+		gls2.mul(R2, R2, x);
+		G2::mul(R1, R1, x);
+		CYBOZU_TEST_EQUAL(R1, R2);
+	}
+}
@@ -0,0 +1,157 @@
+#include <cybozu/test.hpp>
+#include "../src/bls_rand.hpp"
+#include <vector>
+#include <algorithm>
+#include <string.h>
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
+
+using namespace bls::rand;
+
+/*
+	RFC 7539 2.3.2
+*/
+CYBOZU_TEST_AUTO(chacha20Block)
+{
+	uint32_t key[8];
+	for (int i = 0; i < 8; i++) {
+		const uint8_t b[4] = { uint8_t(i * 4), uint8_t(i * 4 + 1), uint8_t(i * 4 + 2), uint8_t(i * 4 + 3) };
+		key[i] = loadU32(b);
+	}
+	const uint32_t nonce[3] = { 0x09000000, 0x4a000000, 0 };
+	const uint8_t expected[64] = {
+		0x10, 0xf1, 0xe7, 0xe4, 0xd1, 0x3b, 0x59, 0x15, 0x50, 0x0f, 0xdd, 0x1f, 0xa3, 0x20, 0x71, 0xc4,
+		0xc7, 0xd1, 0xf4, 0xc7, 0x33, 0xc0, 0x68, 0x03, 0x04, 0x22, 0xaa, 0x9a, 0xc3, 0xd4, 0x6c, 0x4e,
+		0xd2, 0x82, 0x64, 0x46, 0x07, 0x9f, 0xaa, 0x09, 0x14, 0xc2, 0xd7, 0x05, 0xd9, 0x8b, 0x02, 0xa2,
+		0xb5, 0x12, 0x9c, 0xd1, 0xde, 0x16, 0x4e, 0xb9, 0xcb, 0xd0, 0x83, 0xe8, 0xa2, 0x50, 0x3c, 0x4e,
+	};
+	uint8_t out[64];
+	chacha20Block(out, key, 1, nonce);
+	CYBOZU_TEST_EQUAL(memcmp(out, expected, 64), 0);
+}
+
+CYBOZU_TEST_AUTO(ChaCha20)
+{
+	uint8_t seed[ChaCha20::seedSize] = { 1, 2, 3 };
+	ChaCha20 r1, r2;
+	CYBOZU_TEST_ASSERT(r1.needSeed());
+	r1.reseed(seed);
+	r2.reseed(seed);
+	CYBOZU_TEST_ASSERT(!r1.needSeed());
+	// the same seed makes the same stream whatever the size of each read is
+	const size_t n = 5000;
+	std::vector<uint8_t> v1(n), v2(n);
+	r1.read(&v1[0], n);
+	for (size_t pos = 0, m = 1; pos < n; pos += m, m = m * 2 + 1) {
+		r2.read(&v2[pos], std::min(m, n - pos));
+	}
+	CYBOZU_TEST_ASSERT(v1 == v2);
+	// the seeds which differ in one byte make the other streams
+	for (size_t i = 0; i < ChaCha20::seedSize; i += 7) {
+		uint8_t seed2[ChaCha20::seedSize];
+		memcpy(seed2, seed, sizeof(seed2));
+		seed2[i] ^= 1;
+		ChaCha20 r3;
+		r3.reseed(seed2);
+		std::vector<uint8_t> v3(n);
+		r3.read(&v3[0], n);
+		CYBOZU_TEST_ASSERT(v1 != v3);
+	}
+	ChaCha20 r3;
+	r3.reseed(seed);
+	// reseed after reseedInterval bytes
+	std::vector<uint8_t> buf(1024);
+	for (uint64_t i = 0; i < ChaCha20::reseedInterval; i += buf.size()) {
+		r3.read(&buf[0], buf.size());
+	}
+	CYBOZU_TEST_ASSERT(r3.needSeed());
+	r3.reseed(seed);
+	CYBOZU_TEST_ASSERT(!r3.needSeed());
+}
+
+CYBOZU_TEST_AUTO(getEntropy)
+{
+	uint8_t a[64], b[64];
+	CYBOZU_TEST_ASSERT(getEntropy(a, sizeof(a)));
+	CYBOZU_TEST_ASSERT(getEntropy(b, sizeof(b)));
+	CYBOZU_TEST_ASSERT(memcmp(a, b, sizeof(a)) != 0);
+}
+
+#ifndef _WIN32
+/*
+	fork a child which writes n bytes of readRand to a pipe
+*/
+static pid_t forkReadRand(int *fd, size_t n)
+{
+	int pfd[2];
+	if (pipe(pfd) != 0) return -1;
+	const pid_t pid = fork();
+	if (pid == 0) {
+		close(pfd[0]);
+		std::vector<uint8_t> buf(n);
+		const bool ok = readRand(&buf[0], n) && write(pfd[1], &buf[0], n) == ssize_t(n);
+		_exit(ok ? 0 : 1);
+	}
+	close(pfd[1]);
+	*fd = pfd[0];
+	return pid;
+}
+
+static bool readAll(int fd, uint8_t *buf, size_t n)
+{
+	while (n > 0) {
+		const ssize_t r = read(fd, buf, n);
+		if (r <= 0) return false;
+		buf += r;
+		n -= size_t(r);
+	}
+	return true;
+}
+
+CYBOZU_TEST_AUTO(fork)
+{
+	uint8_t seed[ChaCha20::seedSize] = { 1 };
+	ChaCha20 r;
+	r.reseed(seed);
+	const pid_t pid = fork();
+	CYBOZU_TEST_ASSERT(pid >= 0);
+	if (pid == 0) {
+		// the child must not output the same stream as the parent
+		_exit(r.needSeed() ? 0 : 1);
+	}
+	int status = 0;
+	CYBOZU_TEST_EQUAL(waitpid(pid, &status, 0), pid);
+	CYBOZU_TEST_ASSERT(WIFEXITED(status));
+	CYBOZU_TEST_EQUAL(WEXITSTATUS(status), 0);
+	CYBOZU_TEST_ASSERT(!r.needSeed());
+}
+
+CYBOZU_TEST_AUTO(forkReadRand)
+{
+	const size_t n = 64;
+	// seed ChaCha20 of this thread before fork() so that the children inherit its state
+	uint8_t parent[n];
+	CYBOZU_TEST_ASSERT(readRand(parent, n));
+	int fd[2];
+	pid_t pid[2];
+	uint8_t child[2][n];
+	for (int i = 0; i < 2; i++) {
+		pid[i] = forkReadRand(&fd[i], n);
+		CYBOZU_TEST_ASSERT(pid[i] > 0);
+	}
+	for (int i = 0; i < 2; i++) {
+		CYBOZU_TEST_ASSERT(readAll(fd[i], child[i], n));
+		close(fd[i]);
+		int status = 0;
+		CYBOZU_TEST_EQUAL(waitpid(pid[i], &status, 0), pid[i]);
+		CYBOZU_TEST_ASSERT(WIFEXITED(status));
+		CYBOZU_TEST_EQUAL(WEXITSTATUS(status), 0);
+	}
+	CYBOZU_TEST_ASSERT(readRand(parent, n));
+	CYBOZU_TEST_ASSERT(memcmp(child[0], child[1], n) != 0);
+	CYBOZU_TEST_ASSERT(memcmp(child[0], parent, n) != 0);
+	CYBOZU_TEST_ASSERT(memcmp(child[1], parent, n) != 0);
+}
+#endif